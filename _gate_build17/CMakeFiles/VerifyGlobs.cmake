@@ -0,0 +1,68 @@
+# CMAKE generated file: DO NOT EDIT!
+# Generated by CMake Version 3.25
+cmake_policy(SET CMP0009 NEW)
+
+# vmcontainer-sources at lib/CMakeLists.txt:5 (file)
+file(GLOB_RECURSE NEW_GLOB LIST_DIRECTORIES false "/root/repo/lib/*.cpp")
+set(OLD_GLOB
+  "/root/repo/lib/src/vmcontainer/address_plan.cpp"
+  "/root/repo/lib/src/vmcontainer/budget.cpp"
+  "/root/repo/lib/src/vmcontainer/checkpoint.cpp"
+  "/root/repo/lib/src/vmcontainer/dirty_tracking.cpp"
+  "/root/repo/lib/src/vmcontainer/file_storage.cpp"
+  "/root/repo/lib/src/vmcontainer/instrumented.cpp"
+  "/root/repo/lib/src/vmcontainer/memory_tag.cpp"
+  "/root/repo/lib/src/vmcontainer/realtime.cpp"
+  "/root/repo/lib/src/vmcontainer/registry.cpp"
+  "/root/repo/lib/src/vmcontainer/streaming.cpp"
+  "/root/repo/lib/src/vmcontainer/vm.cpp"
+  )
+if(NOT "${NEW_GLOB}" STREQUAL "${OLD_GLOB}")
+  message("-- GLOB mismatch!")
+  file(TOUCH_NOCREATE "/root/repo/_gate_build17/CMakeFiles/cmake.verify_globs")
+endif()
+
+# vmcontainer.test-sources at tests/CMakeLists.txt:3 (file)
+file(GLOB_RECURSE NEW_GLOB LIST_DIRECTORIES false "/root/repo/tests/*.cpp")
+set(OLD_GLOB
+  "/root/repo/tests/detail/algorithms.cpp"
+  "/root/repo/tests/detail/detail.cpp"
+  "/root/repo/tests/detail/streaming.cpp"
+  "/root/repo/tests/detail/value_init_when_moved_from.cpp"
+  "/root/repo/tests/instantiations.cpp"
+  "/root/repo/tests/main.cpp"
+  "/root/repo/tests/pinned_vector/access.cpp"
+  "/root/repo/tests/pinned_vector/advise.cpp"
+  "/root/repo/tests/pinned_vector/alignment.cpp"
+  "/root/repo/tests/pinned_vector/assign.cpp"
+  "/root/repo/tests/pinned_vector/capacity.cpp"
+  "/root/repo/tests/pinned_vector/checkpoint.cpp"
+  "/root/repo/tests/pinned_vector/clear.cpp"
+  "/root/repo/tests/pinned_vector/contiguous.cpp"
+  "/root/repo/tests/pinned_vector/emplace_back.cpp"
+  "/root/repo/tests/pinned_vector/freeze.cpp"
+  "/root/repo/tests/pinned_vector/iterators.cpp"
+  "/root/repo/tests/pinned_vector/offset_ptr.cpp"
+  "/root/repo/tests/pinned_vector/push_back.cpp"
+  "/root/repo/tests/pinned_vector/relocate.cpp"
+  "/root/repo/tests/pinned_vector/special.cpp"
+  "/root/repo/tests/pinned_vector/storage.cpp"
+  "/root/repo/tests/pinned_vector/streaming.cpp"
+  "/root/repo/tests/vm/address_plan.cpp"
+  "/root/repo/tests/vm/budget.cpp"
+  "/root/repo/tests/vm/dirty_tracking.cpp"
+  "/root/repo/tests/vm/dump_policy.cpp"
+  "/root/repo/tests/vm/file_storage.cpp"
+  "/root/repo/tests/vm/fork_policy.cpp"
+  "/root/repo/tests/vm/instrumented.cpp"
+  "/root/repo/tests/vm/memory_tag.cpp"
+  "/root/repo/tests/vm/page_stack.cpp"
+  "/root/repo/tests/vm/realtime.cpp"
+  "/root/repo/tests/vm/registry.cpp"
+  "/root/repo/tests/vm/reservation.cpp"
+  "/root/repo/tests/vm/system_wrapper.cpp"
+  )
+if(NOT "${NEW_GLOB}" STREQUAL "${OLD_GLOB}")
+  message("-- GLOB mismatch!")
+  file(TOUCH_NOCREATE "/root/repo/_gate_build17/CMakeFiles/cmake.verify_globs")
+endif()
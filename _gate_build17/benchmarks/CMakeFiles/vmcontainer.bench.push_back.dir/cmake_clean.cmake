@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/vmcontainer.bench.push_back.dir/push_back.cpp.o"
+  "CMakeFiles/vmcontainer.bench.push_back.dir/push_back.cpp.o.d"
+  "vmcontainer.bench.push_back"
+  "vmcontainer.bench.push_back.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/vmcontainer.bench.push_back.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
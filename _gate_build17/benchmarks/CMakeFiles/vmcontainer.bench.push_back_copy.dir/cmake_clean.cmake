@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/vmcontainer.bench.push_back_copy.dir/push_back_copy.cpp.o"
+  "CMakeFiles/vmcontainer.bench.push_back_copy.dir/push_back_copy.cpp.o.d"
+  "vmcontainer.bench.push_back_copy"
+  "vmcontainer.bench.push_back_copy.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/vmcontainer.bench.push_back_copy.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
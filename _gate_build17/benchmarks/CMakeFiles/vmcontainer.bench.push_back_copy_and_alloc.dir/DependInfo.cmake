@@ -0,0 +1,20 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/benchmarks/push_back_copy_and_alloc.cpp" "benchmarks/CMakeFiles/vmcontainer.bench.push_back_copy_and_alloc.dir/push_back_copy_and_alloc.cpp.o" "gcc" "benchmarks/CMakeFiles/vmcontainer.bench.push_back_copy_and_alloc.dir/push_back_copy_and_alloc.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_gate_build17/lib/CMakeFiles/vmcontainer.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
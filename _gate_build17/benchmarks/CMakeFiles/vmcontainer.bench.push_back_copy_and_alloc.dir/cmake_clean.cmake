@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/vmcontainer.bench.push_back_copy_and_alloc.dir/push_back_copy_and_alloc.cpp.o"
+  "CMakeFiles/vmcontainer.bench.push_back_copy_and_alloc.dir/push_back_copy_and_alloc.cpp.o.d"
+  "vmcontainer.bench.push_back_copy_and_alloc"
+  "vmcontainer.bench.push_back_copy_and_alloc.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/vmcontainer.bench.push_back_copy_and_alloc.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
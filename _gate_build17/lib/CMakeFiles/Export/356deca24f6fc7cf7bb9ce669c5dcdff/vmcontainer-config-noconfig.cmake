@@ -0,0 +1,19 @@
+#----------------------------------------------------------------
+# Generated CMake target import file.
+#----------------------------------------------------------------
+
+# Commands may need to know the format version.
+set(CMAKE_IMPORT_FILE_VERSION 1)
+
+# Import target "vmcontainer::vmcontainer" for configuration ""
+set_property(TARGET vmcontainer::vmcontainer APPEND PROPERTY IMPORTED_CONFIGURATIONS NOCONFIG)
+set_target_properties(vmcontainer::vmcontainer PROPERTIES
+  IMPORTED_LINK_INTERFACE_LANGUAGES_NOCONFIG "CXX"
+  IMPORTED_LOCATION_NOCONFIG "${_IMPORT_PREFIX}/lib/libvmcontainer.a"
+  )
+
+list(APPEND _cmake_import_check_targets vmcontainer::vmcontainer )
+list(APPEND _cmake_import_check_files_for_vmcontainer::vmcontainer "${_IMPORT_PREFIX}/lib/libvmcontainer.a" )
+
+# Commands beyond this point should not need to know the version.
+set(CMAKE_IMPORT_FILE_VERSION)
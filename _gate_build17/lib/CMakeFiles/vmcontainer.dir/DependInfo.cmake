@@ -0,0 +1,29 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/lib/src/vmcontainer/address_plan.cpp" "lib/CMakeFiles/vmcontainer.dir/src/vmcontainer/address_plan.cpp.o" "gcc" "lib/CMakeFiles/vmcontainer.dir/src/vmcontainer/address_plan.cpp.o.d"
+  "/root/repo/lib/src/vmcontainer/budget.cpp" "lib/CMakeFiles/vmcontainer.dir/src/vmcontainer/budget.cpp.o" "gcc" "lib/CMakeFiles/vmcontainer.dir/src/vmcontainer/budget.cpp.o.d"
+  "/root/repo/lib/src/vmcontainer/checkpoint.cpp" "lib/CMakeFiles/vmcontainer.dir/src/vmcontainer/checkpoint.cpp.o" "gcc" "lib/CMakeFiles/vmcontainer.dir/src/vmcontainer/checkpoint.cpp.o.d"
+  "/root/repo/lib/src/vmcontainer/dirty_tracking.cpp" "lib/CMakeFiles/vmcontainer.dir/src/vmcontainer/dirty_tracking.cpp.o" "gcc" "lib/CMakeFiles/vmcontainer.dir/src/vmcontainer/dirty_tracking.cpp.o.d"
+  "/root/repo/lib/src/vmcontainer/file_storage.cpp" "lib/CMakeFiles/vmcontainer.dir/src/vmcontainer/file_storage.cpp.o" "gcc" "lib/CMakeFiles/vmcontainer.dir/src/vmcontainer/file_storage.cpp.o.d"
+  "/root/repo/lib/src/vmcontainer/instrumented.cpp" "lib/CMakeFiles/vmcontainer.dir/src/vmcontainer/instrumented.cpp.o" "gcc" "lib/CMakeFiles/vmcontainer.dir/src/vmcontainer/instrumented.cpp.o.d"
+  "/root/repo/lib/src/vmcontainer/memory_tag.cpp" "lib/CMakeFiles/vmcontainer.dir/src/vmcontainer/memory_tag.cpp.o" "gcc" "lib/CMakeFiles/vmcontainer.dir/src/vmcontainer/memory_tag.cpp.o.d"
+  "/root/repo/lib/src/vmcontainer/realtime.cpp" "lib/CMakeFiles/vmcontainer.dir/src/vmcontainer/realtime.cpp.o" "gcc" "lib/CMakeFiles/vmcontainer.dir/src/vmcontainer/realtime.cpp.o.d"
+  "/root/repo/lib/src/vmcontainer/registry.cpp" "lib/CMakeFiles/vmcontainer.dir/src/vmcontainer/registry.cpp.o" "gcc" "lib/CMakeFiles/vmcontainer.dir/src/vmcontainer/registry.cpp.o.d"
+  "/root/repo/lib/src/vmcontainer/streaming.cpp" "lib/CMakeFiles/vmcontainer.dir/src/vmcontainer/streaming.cpp.o" "gcc" "lib/CMakeFiles/vmcontainer.dir/src/vmcontainer/streaming.cpp.o.d"
+  "/root/repo/lib/src/vmcontainer/vm.cpp" "lib/CMakeFiles/vmcontainer.dir/src/vmcontainer/vm.cpp.o" "gcc" "lib/CMakeFiles/vmcontainer.dir/src/vmcontainer/vm.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
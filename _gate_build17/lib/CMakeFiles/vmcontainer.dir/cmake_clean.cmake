@@ -0,0 +1,31 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/vmcontainer.dir/src/vmcontainer/address_plan.cpp.o"
+  "CMakeFiles/vmcontainer.dir/src/vmcontainer/address_plan.cpp.o.d"
+  "CMakeFiles/vmcontainer.dir/src/vmcontainer/budget.cpp.o"
+  "CMakeFiles/vmcontainer.dir/src/vmcontainer/budget.cpp.o.d"
+  "CMakeFiles/vmcontainer.dir/src/vmcontainer/checkpoint.cpp.o"
+  "CMakeFiles/vmcontainer.dir/src/vmcontainer/checkpoint.cpp.o.d"
+  "CMakeFiles/vmcontainer.dir/src/vmcontainer/dirty_tracking.cpp.o"
+  "CMakeFiles/vmcontainer.dir/src/vmcontainer/dirty_tracking.cpp.o.d"
+  "CMakeFiles/vmcontainer.dir/src/vmcontainer/file_storage.cpp.o"
+  "CMakeFiles/vmcontainer.dir/src/vmcontainer/file_storage.cpp.o.d"
+  "CMakeFiles/vmcontainer.dir/src/vmcontainer/instrumented.cpp.o"
+  "CMakeFiles/vmcontainer.dir/src/vmcontainer/instrumented.cpp.o.d"
+  "CMakeFiles/vmcontainer.dir/src/vmcontainer/memory_tag.cpp.o"
+  "CMakeFiles/vmcontainer.dir/src/vmcontainer/memory_tag.cpp.o.d"
+  "CMakeFiles/vmcontainer.dir/src/vmcontainer/realtime.cpp.o"
+  "CMakeFiles/vmcontainer.dir/src/vmcontainer/realtime.cpp.o.d"
+  "CMakeFiles/vmcontainer.dir/src/vmcontainer/registry.cpp.o"
+  "CMakeFiles/vmcontainer.dir/src/vmcontainer/registry.cpp.o.d"
+  "CMakeFiles/vmcontainer.dir/src/vmcontainer/streaming.cpp.o"
+  "CMakeFiles/vmcontainer.dir/src/vmcontainer/streaming.cpp.o.d"
+  "CMakeFiles/vmcontainer.dir/src/vmcontainer/vm.cpp.o"
+  "CMakeFiles/vmcontainer.dir/src/vmcontainer/vm.cpp.o.d"
+  "libvmcontainer.a"
+  "libvmcontainer.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/vmcontainer.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,55 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/tests/detail/algorithms.cpp" "tests/CMakeFiles/vmcontainer.test.dir/detail/algorithms.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/detail/algorithms.cpp.o.d"
+  "/root/repo/tests/detail/detail.cpp" "tests/CMakeFiles/vmcontainer.test.dir/detail/detail.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/detail/detail.cpp.o.d"
+  "/root/repo/tests/detail/streaming.cpp" "tests/CMakeFiles/vmcontainer.test.dir/detail/streaming.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/detail/streaming.cpp.o.d"
+  "/root/repo/tests/detail/value_init_when_moved_from.cpp" "tests/CMakeFiles/vmcontainer.test.dir/detail/value_init_when_moved_from.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/detail/value_init_when_moved_from.cpp.o.d"
+  "/root/repo/tests/instantiations.cpp" "tests/CMakeFiles/vmcontainer.test.dir/instantiations.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/instantiations.cpp.o.d"
+  "/root/repo/tests/main.cpp" "tests/CMakeFiles/vmcontainer.test.dir/main.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/main.cpp.o.d"
+  "/root/repo/tests/pinned_vector/access.cpp" "tests/CMakeFiles/vmcontainer.test.dir/pinned_vector/access.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/pinned_vector/access.cpp.o.d"
+  "/root/repo/tests/pinned_vector/advise.cpp" "tests/CMakeFiles/vmcontainer.test.dir/pinned_vector/advise.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/pinned_vector/advise.cpp.o.d"
+  "/root/repo/tests/pinned_vector/alignment.cpp" "tests/CMakeFiles/vmcontainer.test.dir/pinned_vector/alignment.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/pinned_vector/alignment.cpp.o.d"
+  "/root/repo/tests/pinned_vector/assign.cpp" "tests/CMakeFiles/vmcontainer.test.dir/pinned_vector/assign.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/pinned_vector/assign.cpp.o.d"
+  "/root/repo/tests/pinned_vector/capacity.cpp" "tests/CMakeFiles/vmcontainer.test.dir/pinned_vector/capacity.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/pinned_vector/capacity.cpp.o.d"
+  "/root/repo/tests/pinned_vector/checkpoint.cpp" "tests/CMakeFiles/vmcontainer.test.dir/pinned_vector/checkpoint.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/pinned_vector/checkpoint.cpp.o.d"
+  "/root/repo/tests/pinned_vector/clear.cpp" "tests/CMakeFiles/vmcontainer.test.dir/pinned_vector/clear.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/pinned_vector/clear.cpp.o.d"
+  "/root/repo/tests/pinned_vector/contiguous.cpp" "tests/CMakeFiles/vmcontainer.test.dir/pinned_vector/contiguous.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/pinned_vector/contiguous.cpp.o.d"
+  "/root/repo/tests/pinned_vector/emplace_back.cpp" "tests/CMakeFiles/vmcontainer.test.dir/pinned_vector/emplace_back.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/pinned_vector/emplace_back.cpp.o.d"
+  "/root/repo/tests/pinned_vector/freeze.cpp" "tests/CMakeFiles/vmcontainer.test.dir/pinned_vector/freeze.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/pinned_vector/freeze.cpp.o.d"
+  "/root/repo/tests/pinned_vector/iterators.cpp" "tests/CMakeFiles/vmcontainer.test.dir/pinned_vector/iterators.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/pinned_vector/iterators.cpp.o.d"
+  "/root/repo/tests/pinned_vector/offset_ptr.cpp" "tests/CMakeFiles/vmcontainer.test.dir/pinned_vector/offset_ptr.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/pinned_vector/offset_ptr.cpp.o.d"
+  "/root/repo/tests/pinned_vector/push_back.cpp" "tests/CMakeFiles/vmcontainer.test.dir/pinned_vector/push_back.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/pinned_vector/push_back.cpp.o.d"
+  "/root/repo/tests/pinned_vector/relocate.cpp" "tests/CMakeFiles/vmcontainer.test.dir/pinned_vector/relocate.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/pinned_vector/relocate.cpp.o.d"
+  "/root/repo/tests/pinned_vector/special.cpp" "tests/CMakeFiles/vmcontainer.test.dir/pinned_vector/special.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/pinned_vector/special.cpp.o.d"
+  "/root/repo/tests/pinned_vector/storage.cpp" "tests/CMakeFiles/vmcontainer.test.dir/pinned_vector/storage.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/pinned_vector/storage.cpp.o.d"
+  "/root/repo/tests/pinned_vector/streaming.cpp" "tests/CMakeFiles/vmcontainer.test.dir/pinned_vector/streaming.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/pinned_vector/streaming.cpp.o.d"
+  "/root/repo/tests/vm/address_plan.cpp" "tests/CMakeFiles/vmcontainer.test.dir/vm/address_plan.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/vm/address_plan.cpp.o.d"
+  "/root/repo/tests/vm/budget.cpp" "tests/CMakeFiles/vmcontainer.test.dir/vm/budget.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/vm/budget.cpp.o.d"
+  "/root/repo/tests/vm/dirty_tracking.cpp" "tests/CMakeFiles/vmcontainer.test.dir/vm/dirty_tracking.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/vm/dirty_tracking.cpp.o.d"
+  "/root/repo/tests/vm/dump_policy.cpp" "tests/CMakeFiles/vmcontainer.test.dir/vm/dump_policy.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/vm/dump_policy.cpp.o.d"
+  "/root/repo/tests/vm/file_storage.cpp" "tests/CMakeFiles/vmcontainer.test.dir/vm/file_storage.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/vm/file_storage.cpp.o.d"
+  "/root/repo/tests/vm/fork_policy.cpp" "tests/CMakeFiles/vmcontainer.test.dir/vm/fork_policy.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/vm/fork_policy.cpp.o.d"
+  "/root/repo/tests/vm/instrumented.cpp" "tests/CMakeFiles/vmcontainer.test.dir/vm/instrumented.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/vm/instrumented.cpp.o.d"
+  "/root/repo/tests/vm/memory_tag.cpp" "tests/CMakeFiles/vmcontainer.test.dir/vm/memory_tag.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/vm/memory_tag.cpp.o.d"
+  "/root/repo/tests/vm/page_stack.cpp" "tests/CMakeFiles/vmcontainer.test.dir/vm/page_stack.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/vm/page_stack.cpp.o.d"
+  "/root/repo/tests/vm/realtime.cpp" "tests/CMakeFiles/vmcontainer.test.dir/vm/realtime.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/vm/realtime.cpp.o.d"
+  "/root/repo/tests/vm/registry.cpp" "tests/CMakeFiles/vmcontainer.test.dir/vm/registry.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/vm/registry.cpp.o.d"
+  "/root/repo/tests/vm/reservation.cpp" "tests/CMakeFiles/vmcontainer.test.dir/vm/reservation.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/vm/reservation.cpp.o.d"
+  "/root/repo/tests/vm/system_wrapper.cpp" "tests/CMakeFiles/vmcontainer.test.dir/vm/system_wrapper.cpp.o" "gcc" "tests/CMakeFiles/vmcontainer.test.dir/vm/system_wrapper.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_gate_build17/lib/CMakeFiles/vmcontainer.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
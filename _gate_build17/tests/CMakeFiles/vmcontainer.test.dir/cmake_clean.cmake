@@ -0,0 +1,81 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/vmcontainer.test.dir/detail/algorithms.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/detail/algorithms.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/detail/detail.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/detail/detail.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/detail/streaming.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/detail/streaming.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/detail/value_init_when_moved_from.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/detail/value_init_when_moved_from.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/instantiations.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/instantiations.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/main.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/main.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/pinned_vector/access.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/pinned_vector/access.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/pinned_vector/advise.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/pinned_vector/advise.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/pinned_vector/alignment.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/pinned_vector/alignment.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/pinned_vector/assign.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/pinned_vector/assign.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/pinned_vector/capacity.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/pinned_vector/capacity.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/pinned_vector/checkpoint.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/pinned_vector/checkpoint.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/pinned_vector/clear.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/pinned_vector/clear.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/pinned_vector/contiguous.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/pinned_vector/contiguous.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/pinned_vector/emplace_back.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/pinned_vector/emplace_back.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/pinned_vector/freeze.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/pinned_vector/freeze.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/pinned_vector/iterators.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/pinned_vector/iterators.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/pinned_vector/offset_ptr.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/pinned_vector/offset_ptr.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/pinned_vector/push_back.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/pinned_vector/push_back.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/pinned_vector/relocate.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/pinned_vector/relocate.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/pinned_vector/special.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/pinned_vector/special.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/pinned_vector/storage.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/pinned_vector/storage.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/pinned_vector/streaming.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/pinned_vector/streaming.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/vm/address_plan.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/vm/address_plan.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/vm/budget.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/vm/budget.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/vm/dirty_tracking.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/vm/dirty_tracking.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/vm/dump_policy.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/vm/dump_policy.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/vm/file_storage.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/vm/file_storage.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/vm/fork_policy.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/vm/fork_policy.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/vm/instrumented.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/vm/instrumented.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/vm/memory_tag.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/vm/memory_tag.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/vm/page_stack.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/vm/page_stack.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/vm/realtime.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/vm/realtime.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/vm/registry.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/vm/registry.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/vm/reservation.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/vm/reservation.cpp.o.d"
+  "CMakeFiles/vmcontainer.test.dir/vm/system_wrapper.cpp.o"
+  "CMakeFiles/vmcontainer.test.dir/vm/system_wrapper.cpp.o.d"
+  "vmcontainer.test"
+  "vmcontainer.test.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/vmcontainer.test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,59 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+#include "vmcontainer/vm.hpp"
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace mknejp
+{
+  namespace vmcontainer
+  {
+    namespace vm
+    {
+      struct address_range;
+      class address_plan;
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// address_plan
+//
+
+struct mknejp::vmcontainer::vm::address_range
+{
+  void* base = nullptr;
+  std::size_t num_bytes = 0;
+};
+
+// Process-wide table of named address ranges for fixed-address reservations.
+// Assigning the same ranges at startup of every process lets data structures with raw pointers into file backed
+// storage be mapped back at the addresses the pointers refer to.
+class mknejp::vmcontainer::vm::address_plan
+{
+public:
+  static auto instance() -> address_plan&;
+
+  // Throws std::invalid_argument if the name is taken, base is not page aligned, or the range overlaps another one.
+  auto assign(std::string name, void* base, std::size_t num_bytes) -> void;
+  auto remove(std::string const& name) -> void;
+  auto clear() -> void;
+
+  // Returns an empty range if the name is not assigned.
+  auto find(std::string const& name) const -> address_range;
+  // Reserve the range assigned to name. Throws std::out_of_range if the name is not assigned and std::system_error if
+  // the range is already in use.
+  auto reserve(std::string const& name) const -> reservation;
+
+private:
+  mutable std::mutex _mutex;
+  std::map<std::string, address_range> _ranges;
+};
@@ -0,0 +1,145 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+#include "vmcontainer/system_wrapper.hpp"
+#include "vmcontainer/vm.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <new>
+#include <utility>
+
+namespace mknejp
+{
+  namespace vmcontainer
+  {
+    namespace vm
+    {
+      class memory_budget;
+
+      template<typename VirtualMemorySystem = system_default>
+      class budgeted_system;
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// memory_budget
+//
+
+// Limits the number of committed bytes of a group of containers. Every budget is charged together with its parent, so
+// a group is bound by its own limits and those of all its ancestors. All groups descend from global() by default.
+//
+// When a charge makes the committed bytes reach the soft limit the soft limit callback is invoked on the committing
+// thread so producers can apply backpressure. Charges beyond the hard limit fail and leave the budget unchanged.
+class mknejp::vmcontainer::vm::memory_budget
+{
+public:
+  static constexpr std::size_t unlimited = std::numeric_limits<std::size_t>::max();
+
+  using callback_type = std::function<auto(memory_budget& budget, std::size_t committed_bytes)->void>;
+
+  explicit memory_budget(std::size_t hard_limit = unlimited, memory_budget* parent = &global());
+  memory_budget(memory_budget const&) = delete;
+  auto operator=(memory_budget const&) -> memory_budget& = delete;
+
+  static auto global() -> memory_budget&;
+  // The memory.max limit of the cgroup (v2) of this process, or unlimited if there is none.
+  static auto cgroup_limit() -> std::size_t;
+
+  // Limits and callbacks must be set before the budget is used concurrently.
+  auto set_hard_limit(std::size_t num_bytes) noexcept -> void { _hard_limit.store(num_bytes); }
+  auto set_soft_limit(std::size_t num_bytes, callback_type callback) -> void;
+
+  // Charge num_bytes to this budget and its ancestors, or nothing if any of them would exceed its hard limit.
+  auto try_charge(std::size_t num_bytes) -> bool;
+  auto uncharge(std::size_t num_bytes) noexcept -> void;
+
+  auto committed_bytes() const noexcept -> std::size_t { return _committed_bytes.load(std::memory_order_relaxed); }
+  auto hard_limit() const noexcept -> std::size_t { return _hard_limit.load(std::memory_order_relaxed); }
+  auto soft_limit() const noexcept -> std::size_t { return _soft_limit; }
+  auto parent() const noexcept -> memory_budget* { return _parent; }
+
+private:
+  auto try_charge_self(std::size_t num_bytes, std::size_t& previous_bytes) noexcept -> bool;
+  auto uncharge_self(std::size_t num_bytes) noexcept -> void;
+
+  std::atomic<std::size_t> _committed_bytes = {0};
+  std::atomic<std::size_t> _hard_limit;
+  std::size_t _soft_limit = unlimited;
+  callback_type _soft_limit_callback;
+  memory_budget* _parent;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// budgeted_system
+//
+
+// Virtual memory system that charges committed pages to a memory_budget. Commits beyond the hard limit of the budget
+// throw std::bad_alloc like any other commit failure.
+template<typename VirtualMemorySystem>
+class mknejp::vmcontainer::vm::budgeted_system : public system_wrapper<VirtualMemorySystem>
+{
+public:
+  using system_wrapper<VirtualMemorySystem>::inner;
+
+  budgeted_system() = default;
+  explicit budgeted_system(memory_budget& budget, VirtualMemorySystem system = VirtualMemorySystem()) noexcept
+    : system_wrapper<VirtualMemorySystem>(std::move(system)), _budget(&budget)
+  {}
+
+  auto commit(void* offset, std::size_t num_bytes) -> void
+  {
+    if(!_budget->try_charge(num_bytes))
+    {
+      throw std::bad_alloc();
+    }
+    try
+    {
+      inner().commit(offset, num_bytes);
+    }
+    catch(...)
+    {
+      _budget->uncharge(num_bytes);
+      throw;
+    }
+  }
+  auto decommit(void* offset, std::size_t num_bytes) -> void
+  {
+    inner().decommit(offset, num_bytes);
+    _budget->uncharge(num_bytes);
+  }
+  // The moved pages are charged to this budget, the system of the source stack uncharges them in discard().
+  auto move_pages(void* from, void* to, std::size_t num_bytes) -> void
+  {
+    if(!_budget->try_charge(num_bytes))
+    {
+      throw std::bad_alloc();
+    }
+    try
+    {
+      inner().move_pages(from, to, num_bytes);
+    }
+    catch(...)
+    {
+      _budget->uncharge(num_bytes);
+      throw;
+    }
+  }
+  auto discard(void* offset, std::size_t num_bytes) noexcept -> void
+  {
+    _budget->uncharge(num_bytes);
+    this->discard_inner(offset, num_bytes);
+  }
+
+  auto budget() const noexcept -> memory_budget& { return *_budget; }
+
+private:
+  memory_budget* _budget = &memory_budget::global();
+};
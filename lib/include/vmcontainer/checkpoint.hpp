@@ -0,0 +1,58 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+#include "vmcontainer/detail.hpp"
+#include "vmcontainer/pinned_vector.hpp"
+#include "vmcontainer/vm.hpp"
+
+#include <cstddef>
+#include <type_traits>
+
+namespace mknejp
+{
+  namespace vmcontainer
+  {
+    // Write the elements of v to fd, which may be any writable file descriptor.
+    template<typename T, typename Traits>
+    auto save(pinned_vector<T, Traits> const& v, int fd) -> void;
+
+    // Map a file written by save() into a new pinned_vector. The pages are mapped copy-on-write and read lazily, so
+    // loading takes constant time and modifying the container never changes the file.
+    template<typename T, typename Traits = pinned_vector_traits>
+    auto load(int fd, max_size_t max_size) -> pinned_vector<T, Traits>;
+
+    namespace detail
+    {
+      struct checkpoint_layout
+      {
+        std::size_t element_size;
+        std::size_t element_alignment;
+        std::size_t count;
+      };
+
+      auto write_checkpoint(int fd, void const* data, checkpoint_layout layout) -> void;
+      // layout.count is ignored on input.
+      auto map_checkpoint(int fd, checkpoint_layout layout, reservation_size_t reserved_bytes)
+        -> released_storage<vm::page_stack>;
+    }
+  }
+}
+
+template<typename T, typename Traits>
+auto mknejp::vmcontainer::save(pinned_vector<T, Traits> const& v, int fd) -> void
+{
+  static_assert(std::is_trivially_copyable<T>::value, "save() requires a trivially copyable value_type");
+  detail::write_checkpoint(fd, v.data(), {sizeof(T), alignof(T), v.size()});
+}
+
+template<typename T, typename Traits>
+auto mknejp::vmcontainer::load(int fd, max_size_t max_size) -> pinned_vector<T, Traits>
+{
+  static_assert(std::is_trivially_copyable<T>::value, "load() requires a trivially copyable value_type");
+  auto loaded = detail::map_checkpoint(fd, {sizeof(T), alignof(T), 0}, max_size.scaled_for_type<T>());
+  return pinned_vector<T, Traits>(std::move(loaded));
+}
@@ -73,6 +73,19 @@ public:
     return std::size_t(0);
   }
 
+  // Request a base address that is a multiple of alignment, which must be a power of two.
+  // Alignments up to the page size are always satisfied, larger ones are achieved by over-reserving.
+  constexpr auto aligned_to(std::size_t alignment) const noexcept -> reservation_size_t
+  {
+    auto result = *this;
+    result._alignment = alignment;
+    return result;
+  }
+  constexpr auto alignment(std::size_t page_size) const noexcept -> std::size_t
+  {
+    return std::max(_alignment, page_size);
+  }
+
 private:
   friend constexpr auto num_bytes(std::size_t n) noexcept -> reservation_size_t;
   friend constexpr auto num_pages(std::size_t n) noexcept -> reservation_size_t;
@@ -87,6 +100,7 @@ private:
 
   unit _unit = unit::bytes;
   std::size_t _count = 0;
+  std::size_t _alignment = 0;
 };
 
 constexpr auto mknejp::vmcontainer::num_bytes(std::size_t n) noexcept -> reservation_size_t
@@ -111,17 +125,25 @@ public:
     switch(_unit)
     {
       case unit::elements:
-        return num_bytes(sizeof(T) * _count);
+        return num_bytes(sizeof(T) * _count).aligned_to(_alignment);
       case unit::bytes:
-        return num_bytes(_count);
+        return num_bytes(_count).aligned_to(_alignment);
       case unit::pages:
-        return num_pages(_count);
+        return num_pages(_count).aligned_to(_alignment);
     }
     // TODO: mark as unreachable
     // assert(false);
     return num_pages(0);
   }
 
+  // Request a base address that is a multiple of alignment, see reservation_size_t::aligned_to().
+  constexpr auto aligned_to(std::size_t alignment) const noexcept -> max_size_t
+  {
+    auto result = *this;
+    result._alignment = alignment;
+    return result;
+  }
+
 private:
   friend constexpr auto max_elements(std::size_t n) noexcept -> max_size_t;
   friend constexpr auto max_bytes(std::size_t n) noexcept -> max_size_t;
@@ -138,6 +160,7 @@ private:
 
   unit _unit = unit::bytes;
   std::size_t _count = 0;
+  std::size_t _alignment = 0;
 };
 
 constexpr auto mknejp::vmcontainer::max_elements(std::size_t n) noexcept -> max_size_t
@@ -208,7 +231,7 @@ auto mknejp::vmcontainer::detail::destroy_at(T* p) -> void
 template<typename ForwardIt>
 auto mknejp::vmcontainer::detail::destroy(ForwardIt first, ForwardIt last) -> void
 {
-  std::for_each(first, last, [](auto& x) { destroy_at(std::addressof(x)); });
+  std::for_each(first, last, [](auto& x) { detail::destroy_at(std::addressof(x)); });
 }
 
 template<typename InputIt, typename ForwardIt>
@@ -226,12 +249,12 @@ auto mknejp::vmcontainer::detail::uninitialized_move_n(InputIt first, std::size_
   {
     for(std::size_t i = 0; i < count; ++first, (void)++current, ++i)
     {
-      construct_at(std::addressof(*current), std::move(*first));
+      detail::construct_at(std::addressof(*current), std::move(*first));
     }
   }
   catch(...)
   {
-    destroy(d_first, current);
+    detail::destroy(d_first, current);
     throw;
   }
   return {first, current};
@@ -245,12 +268,12 @@ auto mknejp::vmcontainer::detail::uninitialized_value_construct_n(ForwardIt firs
   {
     for(std::size_t i = 0; i < count; ++i, (void)++current)
     {
-      construct_at(std::addressof(*current));
+      detail::construct_at(std::addressof(*current));
     }
   }
   catch(...)
   {
-    destroy(first, current);
+    detail::destroy(first, current);
     throw;
   }
   return current;
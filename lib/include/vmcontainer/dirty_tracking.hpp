@@ -0,0 +1,251 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+#include "vmcontainer/system_wrapper.hpp"
+#include "vmcontainer/vm.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace mknejp
+{
+  namespace vmcontainer
+  {
+    namespace vm
+    {
+      class dirty_page_tracker;
+
+      template<typename VirtualMemorySystem = system_default>
+      class dirty_tracking_system;
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// dirty_page_tracker
+//
+
+// Records which committed pages of a reservation are written in which epoch, so incremental savers and replicators
+// only have to copy the pages modified since their last pass. Pages written in the current epoch are writable, all
+// others are write-protected and the first write to them after advance_epoch() is recorded by a SIGSEGV handler before
+// the page is made writable again. Faults outside of tracked pages are passed on to the previously installed handler.
+//
+// All trackers share one process-wide SIGSEGV handler. It is installed by the first tracker, and again by later ones
+// if something else replaced it in the meantime. The handler cannot take locks, so it finds the tracker of a faulting
+// address by scanning a fixed table of 256 slots. At most 256 trackers can exist at the same time, constructing
+// another one throws std::length_error. The handler is installed with SA_ONSTACK, it only runs on an alternate signal
+// stack if the faulting thread set one up with sigaltstack().
+//
+// Only writes by the process itself fault. The kernel does not raise SIGSEGV when it writes to a write-protected page
+// on behalf of a system call, the call fails with EFAULT instead. Reading into tracked pages with read(), recv(),
+// pread() and the like, completing io_uring requests into them, or load() copying a checkpoint into tracked storage
+// fail unless the pages were written since the last advance_epoch(). Touch such pages before passing them to the
+// kernel.
+//
+// Typical use:
+//
+//   auto since = tracker.advance_epoch();
+//   ...
+//   auto const next = tracker.advance_epoch();
+//   for(auto page : tracker.dirty_pages_since(since)) { save(page); }
+//   since = next;
+//
+// Not available on Windows.
+class mknejp::vmcontainer::vm::dirty_page_tracker
+{
+public:
+  using epoch_type = std::uint32_t;
+
+  dirty_page_tracker(void* base, std::size_t reserved_bytes, std::size_t page_size);
+  ~dirty_page_tracker();
+
+  dirty_page_tracker(dirty_page_tracker const&) = delete;
+  auto operator=(dirty_page_tracker const&) -> dirty_page_tracker& = delete;
+
+  auto base() const noexcept -> void* { return _base; }
+  auto page_size() const noexcept -> std::size_t { return _page_size; }
+  auto committed_bytes() const noexcept -> std::size_t { return _committed_bytes.load(std::memory_order_acquire); }
+
+  // Writes are recorded with the current epoch, the first epoch is 1.
+  auto current_epoch() const noexcept -> epoch_type { return _epoch.load(std::memory_order_relaxed); }
+  // Start a new epoch and write-protect the pages written in the previous one. Returns the new epoch.
+  // Must not run concurrently with writes to the tracked pages, otherwise a write may be recorded in the wrong epoch.
+  auto advance_epoch() -> epoch_type;
+  // Indices of the committed pages written in the given epoch or later, in ascending order.
+  auto dirty_pages_since(epoch_type epoch) const -> std::vector<std::size_t>;
+
+  // Newly committed pages count as written in the current epoch.
+  auto record_commit(void* offset, std::size_t num_bytes) -> void;
+  auto record_decommit(void* offset, std::size_t num_bytes) noexcept -> void;
+  // Track the num_bytes reserved right after the tracked range as well. Like advance_epoch() this must not run
+  // concurrently with writes to the tracked pages. If the stamps have to move the old ones are never released, since
+  // the fault handler may still be reading them.
+  auto record_extend(std::size_t num_bytes) -> void;
+  // While frozen, writes are not recorded but passed on as faults. Thawing write-protects the pages that were
+  // protected before the tracker was frozen.
+  auto set_frozen(bool frozen) -> void;
+
+  // Called by the fault handler. Returns false if address is not in a committed page of this tracker.
+  auto handle_write_fault(void* address) noexcept -> bool;
+
+private:
+  auto stamps() const noexcept -> std::atomic<epoch_type>* { return _stamps_base.load(std::memory_order_acquire); }
+
+  auto protect(std::size_t first_page, std::size_t last_page) -> void;
+
+  char* const _base;
+  std::size_t _reserved_bytes;
+  std::size_t const _page_size;
+  // One stamp per page, committed alongside the pages so the fault handler never sees it move while it can run.
+  page_stack _stamps;
+  // What the fault handler reads, _stamps itself may be replaced while it runs.
+  std::atomic<std::atomic<epoch_type>*> _stamps_base;
+  std::atomic<std::size_t> _committed_bytes = {0};
+  std::atomic<epoch_type> _epoch = {1};
+  std::atomic<bool> _frozen = {false};
+  std::size_t _slot;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// dirty_tracking_system
+//
+
+// Virtual memory system that tracks writes to the pages of its reservation with a dirty_page_tracker, accessible with
+// tracker(). Extending the reservation in place must not run concurrently with writes to it, see record_extend().
+// Freezing the storage suspends the tracking until it is thawed.
+//
+// VirtualMemorySystem must provide set_read_only() like system_default.
+template<typename VirtualMemorySystem>
+class mknejp::vmcontainer::vm::dirty_tracking_system : public system_wrapper<VirtualMemorySystem>
+{
+public:
+  using system_wrapper<VirtualMemorySystem>::inner;
+
+  dirty_tracking_system() = default;
+  explicit dirty_tracking_system(VirtualMemorySystem system) noexcept
+    : system_wrapper<VirtualMemorySystem>(std::move(system))
+  {}
+
+  auto reserve(std::size_t num_bytes) -> void* { return track(inner().reserve(num_bytes), num_bytes); }
+  auto reserve_aligned(std::size_t num_bytes, std::size_t alignment) -> void*
+  {
+    return track(inner().reserve_aligned(num_bytes, alignment), num_bytes);
+  }
+  auto reserve_at(void* address, std::size_t num_bytes) -> void*
+  {
+    return track(inner().reserve_at(address, num_bytes), num_bytes);
+  }
+  auto extend(void* offset, std::size_t num_bytes) -> bool
+  {
+    if(!inner().extend(offset, num_bytes))
+    {
+      return false;
+    }
+    try
+    {
+      _tracker->record_extend(num_bytes);
+    }
+    catch(...)
+    {
+      inner().free(offset, num_bytes);
+      throw;
+    }
+    return true;
+  }
+  auto free(void* offset, std::size_t num_bytes) -> void
+  {
+    _tracker.reset();
+    inner().free(offset, num_bytes);
+  }
+  auto commit(void* offset, std::size_t num_bytes) -> void
+  {
+    _tracker->record_commit(offset, num_bytes);
+    try
+    {
+      inner().commit(offset, num_bytes);
+    }
+    catch(...)
+    {
+      _tracker->record_decommit(offset, num_bytes);
+      throw;
+    }
+  }
+  auto decommit(void* offset, std::size_t num_bytes) -> void
+  {
+    _tracker->record_decommit(offset, num_bytes);
+    inner().decommit(offset, num_bytes);
+  }
+  // Remapped pages keep the protection they had in the source reservation.
+  auto move_pages(void* from, void* to, std::size_t num_bytes) -> void
+  {
+    _tracker->record_commit(to, num_bytes);
+    try
+    {
+      inner().move_pages(from, to, num_bytes);
+    }
+    catch(...)
+    {
+      _tracker->record_decommit(to, num_bytes);
+      throw;
+    }
+    inner().set_read_only(to, num_bytes, false);
+  }
+  auto discard(void* offset, std::size_t num_bytes) noexcept -> void
+  {
+    if(_tracker)
+    {
+      _tracker->record_decommit(offset, num_bytes);
+    }
+    this->discard_inner(offset, num_bytes);
+  }
+  // The tracker owns the page protection while the storage is writable.
+  auto set_read_only(void* offset, std::size_t num_bytes, bool read_only) -> void
+  {
+    if(read_only)
+    {
+      _tracker->set_frozen(true);
+      try
+      {
+        inner().set_read_only(offset, num_bytes, true);
+      }
+      catch(...)
+      {
+        _tracker->set_frozen(false);
+        throw;
+      }
+    }
+    else
+    {
+      inner().set_read_only(offset, num_bytes, false);
+      _tracker->set_frozen(false);
+    }
+  }
+
+  auto tracker() const noexcept -> dirty_page_tracker& { return *_tracker; }
+
+private:
+  // Every copy of the system is owned by a single reservation, a copy making a new reservation gets its own tracker.
+  auto track(void* offset, std::size_t num_bytes) -> void*
+  {
+    try
+    {
+      _tracker = std::make_shared<dirty_page_tracker>(offset, num_bytes, inner().page_size());
+    }
+    catch(...)
+    {
+      inner().free(offset, num_bytes);
+      throw;
+    }
+    return offset;
+  }
+
+  std::shared_ptr<dirty_page_tracker> _tracker;
+};
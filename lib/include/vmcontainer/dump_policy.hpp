@@ -0,0 +1,156 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+#include "vmcontainer/detail.hpp"
+#include "vmcontainer/system_wrapper.hpp"
+#include "vmcontainer/vm.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+namespace mknejp
+{
+  namespace vmcontainer
+  {
+    namespace vm
+    {
+      class dump_policy;
+
+      template<typename VirtualMemorySystem = system_default>
+      class dump_policy_system;
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// dump_policy
+//
+
+// How much of a reservation is written to core dumps, counted from its base.
+class mknejp::vmcontainer::vm::dump_policy
+{
+public:
+  static constexpr auto all() noexcept -> dump_policy { return dump_policy(std::numeric_limits<std::size_t>::max()); }
+  static constexpr auto none() noexcept -> dump_policy { return dump_policy(0); }
+  // Only the first num_bytes, for example to keep the header of a large table for diagnostics.
+  static constexpr auto first(std::size_t num_bytes) noexcept -> dump_policy { return dump_policy(num_bytes); }
+
+  constexpr auto included_bytes() const noexcept -> std::size_t { return _included_bytes; }
+
+private:
+  explicit constexpr dump_policy(std::size_t included_bytes) noexcept : _included_bytes(included_bytes) {}
+
+  std::size_t _included_bytes;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// dump_policy_system
+//
+
+// Virtual memory system that excludes the reservations it makes from core dumps according to a dump_policy.
+// Default constructed instances exclude everything, pass an instance with a different policy to the constructor of
+// the containers whose contents are worth keeping.
+//
+// VirtualMemorySystem must provide set_dumpable() like system_default.
+template<typename VirtualMemorySystem>
+class mknejp::vmcontainer::vm::dump_policy_system : public system_wrapper<VirtualMemorySystem>
+{
+public:
+  using system_wrapper<VirtualMemorySystem>::inner;
+
+  dump_policy_system() = default;
+  explicit dump_policy_system(dump_policy policy, VirtualMemorySystem system = VirtualMemorySystem()) noexcept
+    : system_wrapper<VirtualMemorySystem>(std::move(system)), _policy(policy)
+  {}
+
+  auto reserve(std::size_t num_bytes) -> void* { return apply_to_new(inner().reserve(num_bytes), num_bytes); }
+  auto reserve_aligned(std::size_t num_bytes, std::size_t alignment) -> void*
+  {
+    return apply_to_new(inner().reserve_aligned(num_bytes, alignment), num_bytes);
+  }
+  auto reserve_at(void* address, std::size_t num_bytes) -> void*
+  {
+    return apply_to_new(inner().reserve_at(address, num_bytes), num_bytes);
+  }
+  auto extend(void* offset, std::size_t num_bytes) -> bool
+  {
+    if(!inner().extend(offset, num_bytes))
+    {
+      return false;
+    }
+    try
+    {
+      apply(offset, num_bytes, true);
+    }
+    catch(...)
+    {
+      inner().free(offset, num_bytes);
+      throw;
+    }
+    return true;
+  }
+  // Remapped pages carry the dump flags of the reservation they came from.
+  auto move_pages(void* from, void* to, std::size_t num_bytes) -> void
+  {
+    inner().move_pages(from, to, num_bytes);
+    try
+    {
+      apply(to, num_bytes);
+    }
+    catch(...)
+    {
+      // The pages are already moved, leave them with the flags of the source.
+    }
+  }
+
+  auto policy() const noexcept -> dump_policy { return _policy; }
+
+private:
+  // Every copy of the system is owned by a single reservation, so the base of the last reservation made is the one
+  // all later calls refer to.
+  auto apply_to_new(void* offset, std::size_t num_bytes) -> void*
+  {
+    _base = static_cast<char*>(offset);
+    try
+    {
+      apply(offset, num_bytes, true);
+    }
+    catch(...)
+    {
+      inner().free(offset, num_bytes);
+      throw;
+    }
+    return offset;
+  }
+  // New address space is dumpable by default so only the part beyond the included bytes has to be excluded. Remapped
+  // pages need both.
+  auto apply(void* offset, std::size_t num_bytes, bool dumpable_by_default = false) -> void
+  {
+    auto const first = uintptr(offset);
+    auto const last = first + num_bytes;
+    auto const base = uintptr(_base);
+    auto const included = _policy.included_bytes();
+    // A partially included page is included.
+    auto const included_last = included >= last - base ? last : base + detail::round_up(included, inner().page_size());
+    auto const split = std::min(std::max(first, included_last), last);
+    if(split > first && !dumpable_by_default)
+    {
+      inner().set_dumpable(offset, split - first, true);
+    }
+    if(last > split)
+    {
+      inner().set_dumpable(reinterpret_cast<void*>(split), last - split, false);
+    }
+  }
+  static auto uintptr(void const* p) noexcept -> std::uintptr_t { return reinterpret_cast<std::uintptr_t>(p); }
+
+  dump_policy _policy = dump_policy::none();
+  char* _base = nullptr;
+};
@@ -0,0 +1,235 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+#include "vmcontainer/detail.hpp"
+#include "vmcontainer/vm.hpp"
+
+#include <cstddef>
+#include <memory>
+
+namespace mknejp
+{
+  namespace vmcontainer
+  {
+    namespace vm
+    {
+      class file_descriptor;
+
+      class file_page_stack;
+
+      class memfd_page_stack;
+      class memfd_snapshot;
+
+      class shared_page_stack;
+      class shared_page_view;
+
+      // Pass a file descriptor to another local process over a Unix domain socket (SCM_RIGHTS).
+      auto send_fd(int socket, int fd) -> void;
+      auto receive_fd(int socket) -> file_descriptor;
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// file_descriptor
+//
+
+class mknejp::vmcontainer::vm::file_descriptor
+{
+public:
+  file_descriptor() = default;
+  explicit file_descriptor(int fd) noexcept : _fd(fd) {}
+  file_descriptor(file_descriptor&& other) noexcept : _fd(other.release()) {}
+  file_descriptor& operator=(file_descriptor&& other) & noexcept
+  {
+    reset(other.release());
+    return *this;
+  }
+  ~file_descriptor() { reset(); }
+
+  auto get() const noexcept -> int { return _fd; }
+  auto release() noexcept -> int
+  {
+    auto const fd = _fd;
+    _fd = -1;
+    return fd;
+  }
+  auto reset(int fd = -1) noexcept -> void;
+
+  explicit operator bool() const noexcept { return _fd >= 0; }
+
+private:
+  int _fd = -1;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// memfd_snapshot
+//
+
+// Read-only view of the committed pages of a memfd_page_stack at the time the snapshot was taken.
+class mknejp::vmcontainer::vm::memfd_snapshot
+{
+public:
+  memfd_snapshot() = default;
+
+  auto base() const noexcept -> void const* { return _reservation.base(); }
+  auto mapped_bytes() const noexcept -> std::size_t { return _mapped_bytes; }
+
+private:
+  friend class memfd_page_stack;
+
+  memfd_snapshot(reservation reservation,
+                 std::shared_ptr<file_descriptor const> file,
+                 std::size_t mapped_bytes) noexcept
+    : _reservation(std::move(reservation)), _file(std::move(file)), _mapped_bytes(mapped_bytes)
+  {}
+
+  reservation _reservation;
+  std::shared_ptr<file_descriptor const> _file;
+  detail::value_init_when_moved_from<std::size_t> _mapped_bytes = 0;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// memfd_page_stack
+//
+
+// A page stack whose committed pages live in an anonymous memory file (Linux memfd) instead of anonymous memory.
+// snapshot() maps the file a second time copy-on-write, so taking a snapshot costs page table setup only.
+//
+// Taking a snapshot switches the stack itself to a private copy-on-write mapping of the file so later writes cannot
+// leak into the snapshot. The next snapshot() writes the pages modified since then back into the file. If snapshots of
+// the file are still alive it maps the file copy-on-write once more and copies only the modified pages into the new
+// snapshot instead. The stack keeps its private mapping in that case, so the modified pages accumulate until all
+// snapshots of the file are gone, and each snapshot costs memory and time proportional to the pages modified since.
+class mknejp::vmcontainer::vm::memfd_page_stack
+{
+public:
+  using snapshot_type = memfd_snapshot;
+
+  memfd_page_stack() = default;
+  explicit memfd_page_stack(reservation_size_t reserved_bytes);
+
+  auto resize(std::size_t new_bytes) -> std::size_t;
+  auto snapshot() -> memfd_snapshot;
+
+  auto base() const noexcept -> void* { return _reservation.base(); }
+  auto committed_bytes() const noexcept -> std::size_t { return _committed_bytes; }
+  auto reserved_bytes() const noexcept -> std::size_t { return _reservation.reserved_bytes(); }
+  auto page_size() const noexcept -> std::size_t { return system_default::page_size(); }
+  auto fd() const noexcept -> int { return _file ? _file->get() : -1; }
+
+private:
+  auto snapshot_modified_pages() -> memfd_snapshot;
+  auto write_back() -> void;
+
+  reservation _reservation;
+  // Shared with all snapshots of the current file.
+  std::shared_ptr<file_descriptor const> _file;
+  detail::value_init_when_moved_from<std::size_t> _committed_bytes = 0;
+  // Lowest committed size since the pages were last mapped from the file, everything above has been replaced.
+  detail::value_init_when_moved_from<std::size_t> _file_bytes = 0;
+  detail::value_init_when_moved_from<bool> _copy_on_write = false;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// file_page_stack
+//
+
+// A page stack whose committed pages are a shared mapping of a file, so the contents survive the process.
+// The file starts with a header of header_bytes that records how many bytes are in use as of the last flush().
+// Opening an existing file maps its contents in constant time, pages are read lazily on first access.
+class mknejp::vmcontainer::vm::file_page_stack
+{
+public:
+  static constexpr std::size_t header_bytes = 64 * 1024;
+
+  file_page_stack() = default;
+  // The reservation is enlarged if the file is bigger than reserved_bytes.
+  file_page_stack(file_descriptor file, reservation_size_t reserved_bytes);
+  file_page_stack(char const* path, reservation_size_t reserved_bytes);
+  // Map the file at a fixed address so pointers into it stay valid across processes.
+  // Throws std::system_error if the address range is already in use.
+  file_page_stack(file_descriptor file, void* address, reservation_size_t reserved_bytes);
+  file_page_stack(char const* path, void* address, reservation_size_t reserved_bytes);
+
+  auto resize(std::size_t new_bytes) -> std::size_t;
+
+  // Record used_bytes in the header and write all dirty pages up to it to the file.
+  auto flush(std::size_t used_bytes) -> void;
+  // Write the dirty pages intersecting [offset, offset + num_bytes) to the file.
+  auto flush(std::size_t offset, std::size_t num_bytes) -> void;
+  // The number of bytes in use as of the last flush().
+  auto used_bytes() const noexcept -> std::size_t { return _used_bytes; }
+
+  auto base() const noexcept -> void* { return _reservation.base(); }
+  auto committed_bytes() const noexcept -> std::size_t { return _committed_bytes; }
+  auto reserved_bytes() const noexcept -> std::size_t { return _reservation.reserved_bytes(); }
+  auto page_size() const noexcept -> std::size_t { return system_default::page_size(); }
+  auto fd() const noexcept -> int { return _file.get(); }
+
+private:
+  reservation _reservation;
+  file_descriptor _file;
+  detail::value_init_when_moved_from<std::size_t> _committed_bytes = 0;
+  detail::value_init_when_moved_from<std::size_t> _used_bytes = 0;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// shared_page_stack
+//
+
+// A page stack in a memfd that other local processes can map read-only with shared_page_view after receiving fd().
+// The first page of the file is a header with the number of bytes readers may map and the number of bytes published
+// with flush(). Pages released by shrinking are zeroed instead of truncated so readers never fault on them.
+class mknejp::vmcontainer::vm::shared_page_stack
+{
+public:
+  shared_page_stack() = default;
+  explicit shared_page_stack(reservation_size_t reserved_bytes);
+
+  auto resize(std::size_t new_bytes) -> std::size_t;
+  // Make the first used_bytes visible to readers. Everything written before is visible to them afterwards.
+  auto flush(std::size_t used_bytes) -> void;
+
+  auto base() const noexcept -> void*;
+  auto committed_bytes() const noexcept -> std::size_t { return _committed_bytes; }
+  auto reserved_bytes() const noexcept -> std::size_t;
+  auto page_size() const noexcept -> std::size_t { return system_default::page_size(); }
+  auto fd() const noexcept -> int { return _file.get(); }
+
+private:
+  // The header page followed by the pages of the stack.
+  reservation _reservation;
+  file_descriptor _file;
+  detail::value_init_when_moved_from<std::size_t> _committed_bytes = 0;
+  detail::value_init_when_moved_from<std::size_t> _file_bytes = 0;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// shared_page_view
+//
+
+// Read-only mapping of the pages of a shared_page_stack, usually in another process.
+class mknejp::vmcontainer::vm::shared_page_view
+{
+public:
+  shared_page_view() = default;
+  explicit shared_page_view(file_descriptor file);
+
+  // Map the pages the writer committed since the last call and return the number of bytes it published.
+  auto update() -> std::size_t;
+
+  auto base() const noexcept -> void const*;
+  auto mapped_bytes() const noexcept -> std::size_t { return _mapped_bytes; }
+  auto reserved_bytes() const noexcept -> std::size_t;
+  auto page_size() const noexcept -> std::size_t { return system_default::page_size(); }
+
+private:
+  reservation _reservation;
+  file_descriptor _file;
+  detail::value_init_when_moved_from<std::size_t> _mapped_bytes = 0;
+};
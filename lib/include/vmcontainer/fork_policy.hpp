@@ -0,0 +1,101 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+#include "vmcontainer/system_wrapper.hpp"
+#include "vmcontainer/vm.hpp"
+
+#include <cstddef>
+#include <utility>
+
+namespace mknejp
+{
+  namespace vmcontainer
+  {
+    namespace vm
+    {
+      template<typename VirtualMemorySystem = system_default, fork_behavior DefaultBehavior = fork_behavior::copy>
+      class fork_policy_system;
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// fork_policy_system
+//
+
+// Virtual memory system that applies a fork_behavior to every reservation it makes.
+// Select the behavior for all containers of a type with DefaultBehavior in the traits, or per container by passing an
+// instance to the constructor. Large reservations that are not needed in child processes should use
+// fork_behavior::dont_fork or fork_behavior::wipe, otherwise fork() has to copy their page tables.
+//
+// VirtualMemorySystem must provide set_fork_behavior() like system_default.
+template<typename VirtualMemorySystem, mknejp::vmcontainer::vm::fork_behavior DefaultBehavior>
+class mknejp::vmcontainer::vm::fork_policy_system : public system_wrapper<VirtualMemorySystem>
+{
+public:
+  using system_wrapper<VirtualMemorySystem>::inner;
+
+  fork_policy_system() = default;
+  explicit fork_policy_system(fork_behavior behavior, VirtualMemorySystem system = VirtualMemorySystem()) noexcept
+    : system_wrapper<VirtualMemorySystem>(std::move(system)), _behavior(behavior)
+  {}
+
+  auto reserve(std::size_t num_bytes) -> void* { return apply_to_new(inner().reserve(num_bytes), num_bytes); }
+  auto reserve_aligned(std::size_t num_bytes, std::size_t alignment) -> void*
+  {
+    return apply_to_new(inner().reserve_aligned(num_bytes, alignment), num_bytes);
+  }
+  auto reserve_at(void* address, std::size_t num_bytes) -> void*
+  {
+    return apply_to_new(inner().reserve_at(address, num_bytes), num_bytes);
+  }
+  auto extend(void* offset, std::size_t num_bytes) -> bool
+  {
+    if(!inner().extend(offset, num_bytes))
+    {
+      return false;
+    }
+    apply_to_new(offset, num_bytes);
+    return true;
+  }
+  // Remapped pages carry the behavior of the reservation they came from.
+  auto move_pages(void* from, void* to, std::size_t num_bytes) -> void
+  {
+    inner().move_pages(from, to, num_bytes);
+    try
+    {
+      inner().set_fork_behavior(to, num_bytes, _behavior);
+    }
+    catch(...)
+    {
+      // The pages are already moved, leave them with the behavior of the source.
+    }
+  }
+
+  auto behavior() const noexcept -> fork_behavior { return _behavior; }
+
+private:
+  // New address space has fork_behavior::copy, release it again if the behavior cannot be applied.
+  auto apply_to_new(void* offset, std::size_t num_bytes) -> void*
+  {
+    if(_behavior != fork_behavior::copy)
+    {
+      try
+      {
+        inner().set_fork_behavior(offset, num_bytes, _behavior);
+      }
+      catch(...)
+      {
+        inner().free(offset, num_bytes);
+        throw;
+      }
+    }
+    return offset;
+  }
+
+  fork_behavior _behavior = DefaultBehavior;
+};
@@ -0,0 +1,224 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+#include "vmcontainer/system_wrapper.hpp"
+#include "vmcontainer/vm.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// Set to 0 to make instrumented_system forward to the wrapped system without recording anything.
+#ifndef VMCONTAINER_INSTRUMENTATION
+#  define VMCONTAINER_INSTRUMENTATION 1
+#endif
+
+namespace mknejp
+{
+  namespace vmcontainer
+  {
+    namespace vm
+    {
+      enum class operation
+      {
+        reserve,
+        extend,
+        free,
+        commit,
+        decommit,
+        move_pages,
+      };
+      constexpr std::size_t num_operations = 6;
+
+      struct operation_stats;
+      class vm_stats;
+
+      template<typename VirtualMemorySystem = system_default>
+      class instrumented_system;
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// vm_stats
+//
+
+struct mknejp::vmcontainer::vm::operation_stats
+{
+  // Bucket i counts calls that took [2^i, 2^(i+1)) nanoseconds, the last bucket everything longer.
+  static constexpr std::size_t latency_buckets = 32;
+
+  std::uint64_t calls = 0;
+  std::uint64_t failures = 0;
+  std::uint64_t bytes = 0;
+  std::chrono::nanoseconds total_time = {};
+  std::array<std::uint64_t, latency_buckets> latency_histogram = {};
+};
+
+// Thread-safe counters for the calls made through instrumented_system.
+class mknejp::vmcontainer::vm::vm_stats
+{
+public:
+  // Called after every successful operation, for example to emit a tracepoint.
+  using hook_type = void (*)(operation op, void* offset, std::size_t num_bytes, std::chrono::nanoseconds duration);
+
+  vm_stats() noexcept;
+  vm_stats(vm_stats const&) = delete;
+  auto operator=(vm_stats const&) -> vm_stats& = delete;
+
+  // The stats used by default constructed instrumented_system instances.
+  static auto global() noexcept -> vm_stats&;
+
+  auto record(operation op, void* offset, std::size_t num_bytes, std::chrono::nanoseconds duration) noexcept -> void;
+  auto record_failure(operation op) noexcept -> void;
+
+  auto get(operation op) const noexcept -> operation_stats;
+  // Reservations minus frees, an estimate of the number of mappings created through this object.
+  auto live_reservations() const noexcept -> std::int64_t { return _live_reservations.load(std::memory_order_relaxed); }
+
+  auto set_hook(hook_type hook) noexcept -> void { _hook.store(hook, std::memory_order_release); }
+  auto reset() noexcept -> void;
+
+private:
+  struct counters
+  {
+    std::atomic<std::uint64_t> calls;
+    std::atomic<std::uint64_t> failures;
+    std::atomic<std::uint64_t> bytes;
+    std::atomic<std::uint64_t> nanoseconds;
+    std::array<std::atomic<std::uint64_t>, operation_stats::latency_buckets> latency_histogram;
+  };
+
+  std::array<counters, num_operations> _counters;
+  std::atomic<std::int64_t> _live_reservations;
+  std::atomic<hook_type> _hook;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// instrumented_system
+//
+
+// Virtual memory system that forwards to VirtualMemorySystem and records the count, size and latency of every call in
+// a vm_stats object. Queries and hints do not change the mappings and are forwarded without being recorded. With
+// VMCONTAINER_INSTRUMENTATION=0 it stores no stats and takes no more space than the wrapped system, stats() then
+// refers to vm_stats::global() which records nothing.
+template<typename VirtualMemorySystem>
+class mknejp::vmcontainer::vm::instrumented_system : public system_wrapper<VirtualMemorySystem>
+{
+public:
+  using system_wrapper<VirtualMemorySystem>::inner;
+
+  instrumented_system() = default;
+  explicit instrumented_system(vm_stats& stats, VirtualMemorySystem system = VirtualMemorySystem()) noexcept
+#if VMCONTAINER_INSTRUMENTATION
+    : system_wrapper<VirtualMemorySystem>(std::move(system)), _stats(&stats)
+  {}
+#else
+    : system_wrapper<VirtualMemorySystem>(std::move(system))
+  {
+    (void)stats;
+  }
+#endif
+
+  auto reserve(std::size_t num_bytes) -> void*
+  {
+    return instrument(operation::reserve, num_bytes, [&] { return inner().reserve(num_bytes); });
+  }
+  auto reserve_aligned(std::size_t num_bytes, std::size_t alignment) -> void*
+  {
+    return instrument(operation::reserve, num_bytes, [&] { return inner().reserve_aligned(num_bytes, alignment); });
+  }
+  auto reserve_at(void* address, std::size_t num_bytes) -> void*
+  {
+    return instrument(operation::reserve, num_bytes, [&] { return inner().reserve_at(address, num_bytes); });
+  }
+  auto extend(void* offset, std::size_t num_bytes) -> bool
+  {
+    return instrument(operation::extend, num_bytes, [&] { return inner().extend(offset, num_bytes); });
+  }
+  auto free(void* offset, std::size_t num_bytes) -> void
+  {
+    instrument(operation::free, num_bytes, [&] {
+      inner().free(offset, num_bytes);
+      return offset;
+    });
+  }
+  auto commit(void* offset, std::size_t num_bytes) -> void
+  {
+    instrument(operation::commit, num_bytes, [&] {
+      inner().commit(offset, num_bytes);
+      return offset;
+    });
+  }
+  auto decommit(void* offset, std::size_t num_bytes) -> void
+  {
+    instrument(operation::decommit, num_bytes, [&] {
+      inner().decommit(offset, num_bytes);
+      return offset;
+    });
+  }
+  auto move_pages(void* from, void* to, std::size_t num_bytes) -> void
+  {
+    instrument(operation::move_pages, num_bytes, [&] {
+      inner().move_pages(from, to, num_bytes);
+      return to;
+    });
+  }
+
+#if VMCONTAINER_INSTRUMENTATION
+  auto stats() const noexcept -> vm_stats& { return *_stats; }
+#else
+  auto stats() const noexcept -> vm_stats& { return vm_stats::global(); }
+#endif
+
+private:
+  // f returns the address to report to the hook, or whether extend() succeeded. An extend() returning false counts as
+  // a failure.
+  template<typename F>
+  auto instrument(operation op, std::size_t num_bytes, F&& f) -> decltype(f())
+  {
+#if VMCONTAINER_INSTRUMENTATION
+    auto const start = std::chrono::steady_clock::now();
+    try
+    {
+      auto result = f();
+      auto const duration =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+      if(succeeded(result))
+      {
+        _stats->record(op, address_of(result), num_bytes, duration);
+      }
+      else
+      {
+        _stats->record_failure(op);
+      }
+      return result;
+    }
+    catch(...)
+    {
+      _stats->record_failure(op);
+      throw;
+    }
+#else
+    (void)op;
+    (void)num_bytes;
+    return f();
+#endif
+  }
+
+  static auto succeeded(void*) noexcept -> bool { return true; }
+  static auto succeeded(bool extended) noexcept -> bool { return extended; }
+  static auto address_of(void* p) noexcept -> void* { return p; }
+  static auto address_of(bool) noexcept -> void* { return nullptr; }
+
+#if VMCONTAINER_INSTRUMENTATION
+  vm_stats* _stats = &vm_stats::global();
+#endif
+};
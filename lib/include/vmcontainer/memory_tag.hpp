@@ -0,0 +1,156 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+#include "vmcontainer/system_wrapper.hpp"
+#include "vmcontainer/vm.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mknejp
+{
+  namespace vmcontainer
+  {
+    namespace vm
+    {
+      struct memory_tag_stats;
+      class memory_tag;
+
+      template<typename VirtualMemorySystem = system_default>
+      class tagged_system;
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// memory_tag
+//
+
+struct mknejp::vmcontainer::vm::memory_tag_stats
+{
+  std::string name;
+  std::size_t reserved_bytes = 0;
+  std::size_t committed_bytes = 0;
+  std::size_t peak_committed_bytes = 0;
+};
+
+// Accounts the reserved and committed bytes of all reservations made through a tagged_system with this tag, for
+// example all containers of a subsystem. Tags are created on first use and live until the end of the program.
+class mknejp::vmcontainer::vm::memory_tag
+{
+public:
+  memory_tag(memory_tag const&) = delete;
+  auto operator=(memory_tag const&) -> memory_tag& = delete;
+
+  // The tag with the given name, created if it does not exist yet.
+  static auto get(std::string const& name) -> memory_tag&;
+  // The tag of default constructed tagged_system instances.
+  static auto untagged() -> memory_tag&;
+  // Stats of all tags ordered by committed bytes, largest first.
+  static auto all() -> std::vector<memory_tag_stats>;
+  // Write all() as a table to out.
+  static auto dump(std::ostream& out) -> void;
+
+  auto name() const noexcept -> std::string const& { return _name; }
+  auto stats() const -> memory_tag_stats;
+
+  auto record_reserve(std::size_t num_bytes) noexcept -> void;
+  auto record_free(std::size_t num_bytes) noexcept -> void;
+  auto record_commit(std::size_t num_bytes) noexcept -> void;
+  auto record_decommit(std::size_t num_bytes) noexcept -> void;
+
+private:
+  explicit memory_tag(std::string name) : _name(std::move(name)) {}
+
+  std::string const _name;
+  std::atomic<std::size_t> _reserved_bytes = {0};
+  std::atomic<std::size_t> _committed_bytes = {0};
+  std::atomic<std::size_t> _peak_committed_bytes = {0};
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// tagged_system
+//
+
+// Virtual memory system that accounts its reservations to a memory_tag and names them after the tag, so they show up
+// as [anon:name] in /proc/self/maps where the kernel supports it.
+//
+// VirtualMemorySystem must provide set_name() like system_default.
+template<typename VirtualMemorySystem>
+class mknejp::vmcontainer::vm::tagged_system : public system_wrapper<VirtualMemorySystem>
+{
+public:
+  using system_wrapper<VirtualMemorySystem>::inner;
+
+  tagged_system() = default;
+  explicit tagged_system(memory_tag& tag, VirtualMemorySystem system = VirtualMemorySystem()) noexcept
+    : system_wrapper<VirtualMemorySystem>(std::move(system)), _tag(&tag)
+  {}
+
+  auto reserve(std::size_t num_bytes) -> void* { return reserved(inner().reserve(num_bytes), num_bytes); }
+  auto reserve_aligned(std::size_t num_bytes, std::size_t alignment) -> void*
+  {
+    return reserved(inner().reserve_aligned(num_bytes, alignment), num_bytes);
+  }
+  auto reserve_at(void* address, std::size_t num_bytes) -> void*
+  {
+    return reserved(inner().reserve_at(address, num_bytes), num_bytes);
+  }
+  auto extend(void* offset, std::size_t num_bytes) -> bool
+  {
+    if(!inner().extend(offset, num_bytes))
+    {
+      return false;
+    }
+    reserved(offset, num_bytes);
+    return true;
+  }
+  auto free(void* offset, std::size_t num_bytes) -> void
+  {
+    inner().free(offset, num_bytes);
+    _tag->record_free(num_bytes);
+  }
+  auto commit(void* offset, std::size_t num_bytes) -> void
+  {
+    inner().commit(offset, num_bytes);
+    _tag->record_commit(num_bytes);
+  }
+  auto decommit(void* offset, std::size_t num_bytes) -> void
+  {
+    inner().decommit(offset, num_bytes);
+    _tag->record_decommit(num_bytes);
+  }
+  // The moved pages are accounted to this tag, the system of the source stack records their removal in discard().
+  auto move_pages(void* from, void* to, std::size_t num_bytes) -> void
+  {
+    inner().move_pages(from, to, num_bytes);
+    _tag->record_commit(num_bytes);
+    // Remapped pages keep the name of the reservation they came from.
+    inner().set_name(to, num_bytes, _tag->name().c_str());
+  }
+  auto discard(void* offset, std::size_t num_bytes) noexcept -> void
+  {
+    _tag->record_decommit(num_bytes);
+    this->discard_inner(offset, num_bytes);
+  }
+
+  auto tag() const noexcept -> memory_tag& { return *_tag; }
+
+private:
+  auto reserved(void* offset, std::size_t num_bytes) noexcept -> void*
+  {
+    _tag->record_reserve(num_bytes);
+    inner().set_name(offset, num_bytes, _tag->name().c_str());
+    return offset;
+  }
+
+  memory_tag* _tag = &memory_tag::untagged();
+};
@@ -0,0 +1,202 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace mknejp
+{
+  namespace vmcontainer
+  {
+    template<typename T, typename Region, typename Offset = std::uint32_t>
+    class offset_ptr;
+    template<typename T, typename Offset = std::int32_t>
+    class relative_ptr;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// offset_ptr
+//
+
+// A compact pointer to an object in a region of memory that does not move, such as the reservation of a
+// pinned_vector. Region::base() must return the start of the region. T may be incomplete where the offset_ptr is
+// declared, so it can link objects of the same type.
+//
+// If Region::base() is static the offset_ptr converts to T* on its own. Otherwise Region is an object owning the
+// memory, such as a vm::reservation or a page stack, and it has to be passed to the constructor and get().
+//
+// The pointer is stored as an Offset counting multiples of alignof(T) from Region::base(), so a 32 bit offset_ptr
+// addresses up to 4 GiB times the alignment of T. The stored value does not depend on where the region is mapped and
+// can be persisted as is.
+template<typename T, typename Region, typename Offset>
+class mknejp::vmcontainer::offset_ptr
+{
+public:
+  static_assert(std::is_unsigned<Offset>::value, "Offset must be an unsigned integer type");
+
+  using element_type = T;
+  using offset_type = Offset;
+
+  static constexpr Offset null_offset = std::numeric_limits<Offset>::max();
+
+  offset_ptr() = default;
+  /*implicit*/ offset_ptr(std::nullptr_t) noexcept {}
+  explicit offset_ptr(T* p) noexcept : _offset(p ? offset_of(p, Region::base()) : null_offset) {}
+  offset_ptr(T* p, Region const& region) noexcept : _offset(p ? offset_of(p, region.base()) : null_offset) {}
+  template<typename U, typename = std::enable_if_t<std::is_convertible<U*, T*>::value>>
+  /*implicit*/ offset_ptr(offset_ptr<U, Region, Offset> const& other) noexcept : _offset(other.offset())
+  {
+    static_assert(alignof(U) == alignof(T), "offsets are only compatible between types of the same alignment");
+  }
+
+  static auto from_offset(Offset offset) noexcept -> offset_ptr
+  {
+    auto result = offset_ptr();
+    result._offset = offset;
+    return result;
+  }
+
+  auto get() const noexcept -> T* { return pointer_to(Region::base()); }
+  auto get(Region const& region) const noexcept -> T* { return pointer_to(region.base()); }
+  auto offset() const noexcept -> Offset { return _offset; }
+
+  auto operator*() const noexcept -> T& { return *get(); }
+  auto operator->() const noexcept -> T* { return get(); }
+  explicit operator bool() const noexcept { return _offset != null_offset; }
+
+  friend auto operator==(offset_ptr const& lhs, offset_ptr const& rhs) noexcept -> bool
+  {
+    return lhs._offset == rhs._offset;
+  }
+  friend auto operator!=(offset_ptr const& lhs, offset_ptr const& rhs) noexcept -> bool
+  {
+    return lhs._offset != rhs._offset;
+  }
+
+private:
+  auto pointer_to(void const* base) const noexcept -> T*
+  {
+    if(_offset == null_offset)
+    {
+      return nullptr;
+    }
+    return reinterpret_cast<T*>(const_cast<char*>(static_cast<char const*>(base)) + std::size_t(_offset) * alignof(T));
+  }
+
+  static auto offset_of(T* p, void const* region_base) noexcept -> Offset
+  {
+    auto const* const base = static_cast<char const*>(region_base);
+    auto const* const q = reinterpret_cast<char const*>(p);
+    assert(q >= base);
+    auto const num_bytes = static_cast<std::size_t>(q - base);
+    assert(num_bytes % alignof(T) == 0);
+    assert(num_bytes / alignof(T) < null_offset);
+    return static_cast<Offset>(num_bytes / alignof(T));
+  }
+
+  Offset _offset = null_offset;
+};
+
+template<typename T, typename Region, typename Offset>
+constexpr Offset mknejp::vmcontainer::offset_ptr<T, Region, Offset>::null_offset;
+
+///////////////////////////////////////////////////////////////////////////////
+// relative_ptr
+//
+
+// A compact pointer that stores the distance in bytes from its own address to the object it points to, so it needs
+// no knowledge of the region it lives in. Links between objects in the same region stay valid when the whole region
+// is moved, copied or mapped elsewhere, for example the elements of any pinned_vector, a shared_page_stack mapped into
+// another process, or a snapshot.
+//
+// relative_ptr is trivially copyable so the objects containing it can be used with save(), load(), split_off(),
+// relocate_to_larger_reservation() and snapshot(). Copying it copies the distance, so the copy only points to the same
+// object if it is at the same position relative to it, as when copying the whole region. Assign p.get() to point to
+// the object of p from elsewhere. A 32 bit relative_ptr reaches objects up to 2 GiB away in either direction, which
+// usually excludes temporaries on the stack pointing into a reservation, so assign pointers to the relative_ptr in
+// place.
+template<typename T, typename Offset>
+class mknejp::vmcontainer::relative_ptr
+{
+public:
+  static_assert(std::is_signed<Offset>::value && std::is_integral<Offset>::value,
+                "Offset must be a signed integer type");
+
+  using element_type = T;
+  using offset_type = Offset;
+
+  // 0 is a valid distance for an object containing a relative_ptr to itself as its first member.
+  static constexpr Offset null_offset = std::numeric_limits<Offset>::min();
+
+  relative_ptr() = default;
+  /*implicit*/ relative_ptr(std::nullptr_t) noexcept {}
+  explicit relative_ptr(T* p) noexcept : _offset(offset_to(p)) {}
+  // Only adds qualifiers, any other conversion could adjust the pointer and change the distance.
+  template<typename U,
+           typename = std::enable_if_t<std::is_convertible<U*, T*>::value
+                                       && std::is_same<std::remove_cv_t<U>, std::remove_cv_t<T>>::value>>
+  /*implicit*/ relative_ptr(relative_ptr<U, Offset> const& other) noexcept : _offset(other.offset())
+  {}
+
+  auto operator=(std::nullptr_t) noexcept -> relative_ptr&
+  {
+    _offset = null_offset;
+    return *this;
+  }
+  auto operator=(T* p) noexcept -> relative_ptr&
+  {
+    _offset = offset_to(p);
+    return *this;
+  }
+
+  auto get() const noexcept -> T*
+  {
+    if(_offset == null_offset)
+    {
+      return nullptr;
+    }
+    // Integer arithmetic, the object need not be part of the same array as this.
+    return reinterpret_cast<T*>(address() + static_cast<std::uintptr_t>(static_cast<std::intptr_t>(_offset)));
+  }
+  auto offset() const noexcept -> Offset { return _offset; }
+
+  auto operator*() const noexcept -> T& { return *get(); }
+  auto operator->() const noexcept -> T* { return get(); }
+  explicit operator bool() const noexcept { return _offset != null_offset; }
+
+  friend auto operator==(relative_ptr const& lhs, relative_ptr const& rhs) noexcept -> bool
+  {
+    return lhs.get() == rhs.get();
+  }
+  friend auto operator!=(relative_ptr const& lhs, relative_ptr const& rhs) noexcept -> bool
+  {
+    return lhs.get() != rhs.get();
+  }
+
+private:
+  auto address() const noexcept -> std::uintptr_t { return reinterpret_cast<std::uintptr_t>(this); }
+
+  auto offset_to(T const* p) const noexcept -> Offset
+  {
+    if(p == nullptr)
+    {
+      return null_offset;
+    }
+    auto const distance = static_cast<std::intptr_t>(reinterpret_cast<std::uintptr_t>(p) - address());
+    assert(distance > std::intptr_t(null_offset) && distance <= std::intptr_t(std::numeric_limits<Offset>::max()));
+    return static_cast<Offset>(distance);
+  }
+
+  Offset _offset = null_offset;
+};
+
+template<typename T, typename Offset>
+constexpr Offset mknejp::vmcontainer::relative_ptr<T, Offset>::null_offset;
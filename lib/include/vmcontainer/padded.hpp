@@ -0,0 +1,55 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace mknejp
+{
+  namespace vmcontainer
+  {
+    // Minimum distance between objects written by different threads to avoid false sharing.
+    constexpr std::size_t cache_line_size = 64;
+
+    template<typename T, std::size_t Alignment = cache_line_size>
+    struct padded;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// padded
+//
+
+// Stores a T aligned to and padded up to a multiple of Alignment.
+// pinned_vector<padded<T>> places every element on its own cache lines so threads writing to neighbouring elements
+// do not contend for the same cache line.
+template<typename T, std::size_t Alignment>
+struct alignas(Alignment) mknejp::vmcontainer::padded
+{
+  static_assert(Alignment >= alignof(T), "Alignment must not be smaller than alignof(T)");
+
+  using value_type = T;
+
+  padded() = default;
+  // Excludes padded itself so copies of non-const objects use the copy constructor.
+  template<typename Arg,
+           typename = std::enable_if_t<!std::is_same<std::decay_t<Arg>, padded>::value
+                                       && std::is_constructible<T, Arg&&>::value>>
+  explicit padded(Arg&& arg) noexcept(std::is_nothrow_constructible<T, Arg&&>::value) : value(std::forward<Arg>(arg))
+  {}
+  template<typename... Args,
+           typename = std::enable_if_t<(sizeof...(Args) > 1) && std::is_constructible<T, Args&&...>::value>>
+  /*implicit*/ padded(Args&&... args) noexcept(std::is_nothrow_constructible<T, Args&&...>::value)
+    : value(std::forward<Args>(args)...)
+  {}
+
+  T value;
+
+  /*implicit*/ operator T&() & noexcept { return value; }
+  /*implicit*/ operator T const&() const& noexcept { return value; }
+};
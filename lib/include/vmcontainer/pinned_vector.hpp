@@ -6,11 +6,14 @@
 
 #pragma once
 #include "vmcontainer/detail.hpp"
+#include "vmcontainer/streaming.hpp"
 #include "vmcontainer/vm.hpp"
 
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <initializer_list>
 #include <iterator>
 #include <ratio>
@@ -22,8 +25,14 @@ namespace mknejp
   {
     struct pinned_vector_traits;
 
+    template<typename Storage>
+    struct released_storage;
+
     template<typename T, typename Traits = pinned_vector_traits>
     class pinned_vector;
+
+    template<typename T, typename Snapshot>
+    class pinned_snapshot;
   }
 }
 
@@ -37,6 +46,18 @@ struct mknejp::vmcontainer::pinned_vector_traits
   using growth_factor = std::ratio<2, 1>;
 };
 
+///////////////////////////////////////////////////////////////////////////////
+// released_storage
+//
+
+// The storage of a pinned_vector after it gave up ownership of it, together with the number of bytes in use.
+template<typename Storage>
+struct mknejp::vmcontainer::released_storage
+{
+  Storage storage;
+  std::size_t used_bytes = 0;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 // pinned_vector
 //
@@ -67,7 +88,7 @@ public:
 
   // constructors
   pinned_vector() = default;
-  explicit pinned_vector(max_size_t max_size) : _storage(max_size.scaled_for_type<T>()) {}
+  explicit pinned_vector(max_size_t max_size) : _storage(reservation_size(max_size)) {}
 
   pinned_vector(max_size_t max_size, std::initializer_list<T> init) : pinned_vector(max_size) { insert(end(), init); }
 
@@ -90,15 +111,79 @@ public:
   template<typename U = T, typename = typename std::enable_if<std::is_default_constructible<U>::value>::type>
   pinned_vector(max_size_t max_size, size_type count) : pinned_vector(max_size)
   {
-    reserve(count);
-    _end = detail::uninitialized_value_construct_n(data(), count);
+    value_construct_until(count);
+    note_used();
+  }
+
+  // Constructors with a virtual memory system instance for storage types that support one.
+  // The system is propagated on copy, move and swap.
+  template<typename S = storage_type>
+  pinned_vector(max_size_t max_size, typename S::vm_system_type const& vm_system)
+    : _storage(reservation_size(max_size), vm_system)
+  {}
+
+  template<typename S = storage_type>
+  pinned_vector(max_size_t max_size, std::initializer_list<T> init, typename S::vm_system_type const& vm_system)
+    : pinned_vector(max_size, vm_system)
+  {
+    insert(end(), init);
+  }
+
+  template<typename InputIter,
+           typename S = storage_type,
+           typename = typename std::enable_if<
+             std::is_base_of<std::input_iterator_tag,
+                             typename std::iterator_traits<InputIter>::iterator_category>::value>::type>
+  // requires InputIterator<InputIter>
+  pinned_vector(max_size_t max_size, InputIter first, InputIter last, typename S::vm_system_type const& vm_system)
+    : pinned_vector(max_size, vm_system)
+  {
+    insert(end(), first, last);
+  }
+
+  template<typename U = T,
+           typename S = storage_type,
+           typename = typename std::enable_if<std::is_copy_constructible<U>::value>::type>
+  pinned_vector(max_size_t max_size, size_type count, T const& value, typename S::vm_system_type const& vm_system)
+    : pinned_vector(max_size, vm_system)
+  {
+    insert(end(), count, value);
+  }
+
+  template<typename U = T,
+           typename S = storage_type,
+           typename = typename std::enable_if<std::is_default_constructible<U>::value>::type>
+  pinned_vector(max_size_t max_size, size_type count, typename S::vm_system_type const& vm_system)
+    : pinned_vector(max_size, vm_system)
+  {
+    value_construct_until(count);
+    note_used();
+  }
+
+  // Adopt storage whose first count * sizeof(T) bytes already hold objects of type T. They must be committed.
+  template<typename U = T, typename = typename std::enable_if<std::is_trivially_copyable<U>::value>::type>
+  explicit pinned_vector(storage_type storage, size_type count) : _storage(std::move(storage))
+  {
+    assert(reinterpret_cast<std::uintptr_t>(data()) % alignof(T) == 0);
+    assert(count <= _storage.committed_bytes() / sizeof(T));
+    _end = data() + count;
+    note_used();
+  }
+  // Adopt storage released by another pinned_vector, possibly with a different value_type.
+  template<typename U = T, typename = typename std::enable_if<std::is_trivially_copyable<U>::value>::type>
+  explicit pinned_vector(released_storage<storage_type> released)
+    : pinned_vector(std::move(released.storage), released.used_bytes / sizeof(T))
+  {
+    assert(released.used_bytes % sizeof(T) == 0);
   }
 
   // Special members
-  pinned_vector(pinned_vector const& other) : _storage(num_bytes(other._storage.reserved_bytes()))
+  pinned_vector(pinned_vector const& other)
+    : _storage(make_storage(reservation_size(same_max_size(other)), other._storage, 0))
   {
     _storage.resize(other.size() * sizeof(T));
-    _end = std::uninitialized_copy(other.cbegin(), other.cend(), data());
+    _end = detail::uninitialized_copy(other.cbegin(), other.cend(), data());
+    note_used();
   }
   pinned_vector(pinned_vector&& other) = default;
   pinned_vector& operator=(pinned_vector const& other) &
@@ -121,7 +206,7 @@ public:
     return *this;
   }
 
-  ~pinned_vector() { clear(); }
+  ~pinned_vector() { detail::destroy(begin(), end()); }
 
   // Assign
   auto assign(std::size_t count, T const& value) -> void
@@ -236,6 +321,44 @@ public:
     }
   }
   auto page_size() const noexcept -> std::size_t { return _storage.page_size(); }
+  // Residency of the committed pages, see vm::system_default::residency().
+  template<typename S = storage_type>
+  auto residency() const -> decltype(std::declval<S const&>().residency())
+  {
+    return _storage.residency();
+  }
+  // Residency of the pages holding the elements [first, first + count).
+  template<typename S = storage_type>
+  auto residency(size_type first, size_type count) const
+    -> decltype(std::declval<S const&>().residency(std::size_t(), std::size_t()))
+  {
+    assert(first <= size() && count <= size() - first);
+    auto const first_byte = first * sizeof(T) / page_size() * page_size();
+    auto const last_byte = detail::round_up((first + count) * sizeof(T), page_size());
+    return _storage.residency(first_byte, std::min(last_byte, _storage.committed_bytes()) - first_byte);
+  }
+  // Tell the system how the elements [first, last) are going to be accessed. The hint applies to all pages holding
+  // them. Returns false if the hint is not supported. Only available if the storage supports it.
+  template<typename S = storage_type>
+  auto advise(const_iterator first, const_iterator last, vm::access_hint hint)
+    -> decltype(std::declval<S&>().advise(std::size_t(), std::size_t(), hint))
+  {
+    assert(is_valid_last_iterator(last));
+    assert(first <= last);
+    return _storage.advise((first - cbegin()) * sizeof(T), (last - first) * sizeof(T), hint);
+  }
+  // The virtual memory system of storage types that have one.
+  template<typename S = storage_type>
+  auto vm_system() const noexcept -> decltype(std::declval<S const&>().vm_system())
+  {
+    return _storage.vm_system();
+  }
+  // Try to raise max_size() without moving the elements by extending the reservation in place.
+  // Returns false and leaves the container untouched if the address space after the reservation is taken.
+  auto try_grow_max_size(max_size_t new_max_size) -> bool
+  {
+    return _storage.try_extend(reservation_size(new_max_size));
+  }
 
   // Modifiers
 
@@ -243,6 +366,7 @@ public:
   {
     detail::destroy(begin(), end());
     _end = data();
+    note_used();
   }
   auto insert(const_iterator pos, T const& value) ->
     typename std::enable_if<std::is_copy_constructible<T&>::value, iterator>::type
@@ -260,7 +384,8 @@ public:
   auto insert(const_iterator pos, size_type count, const T& value) -> iterator
   {
     assert(is_valid_last_iterator(pos));
-    return range_insert_impl(pos, count, [&value](T* first, T* last) { std::fill(first, last, value); });
+    return range_insert_impl(
+      pos, count, [&value](T* first, T* last) { detail::fill_n(first, static_cast<size_type>(last - first), value); });
   }
 
   template<typename InputIter>
@@ -287,7 +412,7 @@ private:
   auto insert(const_iterator pos, InputIter first, InputIter last, std::forward_iterator_tag) -> iterator
   {
     return range_insert_impl(pos, static_cast<size_type>(std::distance(first, last)), [&](T* d_first, T* d_last) {
-      std::copy(first, last, d_first);
+      detail::copy(first, last, d_first);
     });
   }
 
@@ -306,6 +431,7 @@ private:
       }
       fill(p, p + count);
       _end += count;
+      note_used();
     }
     return iterator(p);
   }
@@ -315,7 +441,7 @@ public:
   {
     assert(is_valid_last_iterator(pos));
     return range_insert_impl(
-      pos, ilist.size(), [&](T* d_first, T* d_last) { std::copy(ilist.begin(), ilist.end(), d_first); });
+      pos, ilist.size(), [&](T* d_first, T* d_last) { detail::copy(ilist.begin(), ilist.end(), d_first); });
   }
   template<typename... Args>
   auto emplace(const_iterator pos, Args&&... args) ->
@@ -334,6 +460,7 @@ public:
     }
     auto* x = detail::construct_at(p, std::forward<Args>(args)...);
     ++_end;
+    note_used();
     return *x;
   }
   auto erase(const_iterator pos) -> iterator
@@ -341,6 +468,7 @@ public:
     assert(is_valid_iterator(pos));
     std::move(to_iterator(pos) + 1, end(), to_iterator(pos));
     detail::destroy_at(--_end);
+    note_used();
     return pos;
   }
   auto erase(const_iterator first, const_iterator last) -> iterator
@@ -350,6 +478,7 @@ public:
     std::move(to_iterator(last), end(), to_iterator(first));
     detail::destroy(to_iterator(last), end());
     _end = to_pointer(last);
+    note_used();
     return last;
   }
   template<typename U = T>
@@ -366,27 +495,31 @@ public:
   auto emplace_back(Args&&... args) -> typename std::enable_if<std::is_constructible<T, Args&&...>::value, T&>::type
   {
     grow_if_necessary(1);
-    detail::construct_at(_end.value, std::forward<Args>(args)...);
-    return *_end++;
+    auto* x = detail::construct_at(_end.value, std::forward<Args>(args)...);
+    ++_end;
+    note_used();
+    return *x;
   }
   auto pop_back() -> void
   {
     assert(!empty());
     detail::destroy_at(--_end);
+    note_used();
   }
   template<typename U = T, typename = typename std::enable_if<std::is_default_constructible<U>::value>::type>
   auto resize(size_type count) -> void
   {
     if(count > size())
     {
-      reserve(count);
-      _end = detail::uninitialized_value_construct_n(_end.value, count - size());
+      value_construct_until(count);
+      note_used();
     }
     else if(count < size())
     {
       auto const delta = size() - count;
       detail::destroy(_end - delta, _end.value);
       _end -= delta;
+      note_used();
       shrink_to_fit();
     }
   }
@@ -396,16 +529,138 @@ public:
     if(count > old_size)
     {
       reserve(count);
-      _end = std::uninitialized_fill_n(_end.value, count - old_size, value);
+      _end = detail::uninitialized_fill_n(_end.value, count - old_size, value);
+      note_used();
     }
     else if(count < old_size)
     {
       auto const delta = old_size - count;
       detail::destroy(_end - delta, _end.value);
       _end -= delta;
+      note_used();
       shrink_to_fit();
     }
   }
+  // Move the elements into a new and larger reservation by remapping their pages instead of copying them.
+  // This is the only operation that moves the elements. It invalidates all pointers, references and iterators
+  // and returns the new data() so callers can rebase the pointers they hold.
+  template<typename U = T>
+  auto relocate_to_larger_reservation(max_size_t new_max_size) ->
+    typename std::enable_if<std::is_trivially_copyable<U>::value, T*>::type
+  {
+    auto const old_size = size();
+    auto storage = make_storage(reservation_size(new_max_size), _storage, 0);
+    assert(storage.reserved_bytes() >= _storage.reserved_bytes());
+    storage.append_pages_from(_storage, 0);
+    _storage = std::move(storage);
+    _end = data() + old_size;
+    note_used();
+    return data();
+  }
+  // Move the elements [index, size()) into a new container with the same max_size(). The committed pages are remapped
+  // if index * sizeof(T) is a multiple of the page size, the partially used last page included. Element 0 of a
+  // container always starts its reservation, so a seam inside a page would shift the contents of every page and the
+  // elements are copied instead. Either way the pages behind the seam are released.
+  template<typename U = T>
+  auto split_off(size_type index) -> typename std::enable_if<std::is_trivially_copyable<U>::value, pinned_vector>::type
+  {
+    assert(index <= size());
+    auto result = pinned_vector(make_storage(reservation_size(same_max_size(*this)), _storage, 0), 0);
+    auto const count = size() - index;
+    auto const offset = index * sizeof(T);
+    if(offset % page_size() == 0)
+    {
+      result._storage.append_pages_from(_storage, std::min(offset, _storage.committed_bytes()));
+    }
+    else
+    {
+      result.reserve(count);
+      std::memcpy(result.data(), data() + index, count * sizeof(T));
+      _storage.resize(std::min(detail::round_up(offset, page_size()), _storage.committed_bytes()));
+    }
+    result._end = result.data() + count;
+    _end = data() + index;
+    result.note_used();
+    note_used();
+    return result;
+  }
+  // Move the elements of other behind the last element and leave other empty. The committed pages of other are remapped
+  // if size() * sizeof(T) is a multiple of the page size, the partially used last page included, otherwise the
+  // elements are copied for the same reason as in split_off().
+  template<typename U = T>
+  auto append_pages(pinned_vector&& other) -> typename std::enable_if<std::is_trivially_copyable<U>::value, void>::type
+  {
+    assert(this != std::addressof(other));
+    assert(max_size() - size() >= other.size());
+    if(other.empty())
+    {
+      return;
+    }
+    auto const count = other.size();
+    auto const used_bytes = size() * sizeof(T);
+    other.shrink_to_fit();
+    if(used_bytes % page_size() == 0 && _storage.reserved_bytes() - used_bytes >= other._storage.committed_bytes())
+    {
+      // Drop the spare capacity so the pages of other land right behind the last element.
+      _storage.resize(used_bytes);
+      _storage.append_pages_from(other._storage, 0);
+    }
+    else
+    {
+      reserve(size() + count);
+      std::memcpy(_end.value, other.data(), count * sizeof(T));
+    }
+    _end += count;
+    other._end = other.data();
+    note_used();
+    other.note_used();
+  }
+  // Capture the elements in a read-only view that is not affected by later modifications of the container.
+  // Only available if the storage supports snapshots.
+  template<typename S = storage_type>
+  auto snapshot() -> pinned_snapshot<T, decltype(std::declval<S&>().snapshot())>
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "snapshots require a trivially copyable value_type");
+    return {_storage.snapshot(), size()};
+  }
+  // Persist the elements to the backing file of the storage so they can be adopted again after a restart.
+  // Only available if the storage is backed by a file.
+  template<typename S = storage_type>
+  auto flush() -> decltype(std::declval<S&>().flush(std::size_t()))
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "flushing requires a trivially copyable value_type");
+    return _storage.flush(size() * sizeof(T));
+  }
+  // Make the elements read-only and decommit the capacity beyond size(). The container must not be modified until
+  // thaw(), debug builds assert so. Identical pages of several processes can be merged by the kernel if mergeable is
+  // true. Returns false if merging was requested but is not supported. Only available if the storage supports it.
+  template<typename S = storage_type>
+  auto freeze(bool mergeable = false) -> decltype(std::declval<S&>().freeze(bool()))
+  {
+    static_assert(std::is_trivially_destructible<T>::value, "freezing requires a trivially destructible value_type");
+    shrink_to_fit();
+    return _storage.freeze(mergeable);
+  }
+  template<typename S = storage_type>
+  auto thaw() -> decltype(std::declval<S&>().thaw())
+  {
+    _storage.thaw();
+  }
+  template<typename S = storage_type>
+  auto frozen() const noexcept -> decltype(std::declval<S const&>().frozen())
+  {
+    return _storage.frozen();
+  }
+  // Give up ownership of the storage without destroying the elements. Leaves the container as if default constructed.
+  template<typename U = T>
+  auto release_storage() noexcept ->
+    typename std::enable_if<std::is_trivially_copyable<U>::value, released_storage<storage_type>>::type
+  {
+    auto const used_bytes = size() * sizeof(T);
+    auto released = released_storage<storage_type>{std::move(_storage), used_bytes};
+    _end = data();
+    return released;
+  }
   auto swap(pinned_vector& other) noexcept -> void
   {
     using std::swap;
@@ -414,10 +669,97 @@ public:
   }
 
 private:
+  // Create storage with the same virtual memory system as other if the storage type has one.
+  template<typename S>
+  static auto make_storage(reservation_size_t reserved_bytes, S const& other, int)
+    -> decltype(S(reserved_bytes, other.vm_system()))
+  {
+    return S(reserved_bytes, other.vm_system());
+  }
+  template<typename S>
+  static auto make_storage(reservation_size_t reserved_bytes, S const&, long) -> S
+  {
+    return S(reserved_bytes);
+  }
+
+  // Report the bytes in use to storage types that track them, like vm::registered_page_stack. This is also where such
+  // storage honours pending trim requests.
+  template<typename S>
+  static auto note_used(S& storage, std::size_t used_bytes, int) noexcept -> decltype(storage.note_used(used_bytes))
+  {
+    storage.note_used(used_bytes);
+  }
+  template<typename S>
+  static auto note_used(S&, std::size_t, long) noexcept -> void
+  {}
+  auto note_used() noexcept -> void
+  {
+    assert_mutable();
+    note_used(_storage, size() * sizeof(T), 0);
+  }
+
+  template<typename S>
+  static auto is_frozen(S const& storage, int) noexcept -> decltype(storage.frozen())
+  {
+    return storage.frozen();
+  }
+  template<typename S>
+  static auto is_frozen(S const&, long) noexcept -> bool
+  {
+    return false;
+  }
+  auto assert_mutable() const noexcept -> void { assert(!is_frozen(_storage, 0) && "pinned_vector is frozen"); }
+
+  // Value types aligned beyond the page size need a reservation with at least the same alignment.
+  static constexpr auto reservation_size(max_size_t max_size) noexcept -> reservation_size_t
+  {
+    auto const reserved_bytes = max_size.scaled_for_type<T>();
+    return reserved_bytes.aligned_to(reserved_bytes.alignment(alignof(T)));
+  }
+
+  // Storage types that remember the alignment requested for their reservation pass it on to copies and split_off().
+  template<typename S>
+  static auto alignment(S const& storage, int) noexcept -> decltype(storage.alignment())
+  {
+    return storage.alignment();
+  }
+  template<typename S>
+  static auto alignment(S const&, long) noexcept -> std::size_t
+  {
+    return 0;
+  }
+  static auto same_max_size(pinned_vector const& other) noexcept -> max_size_t
+  {
+    return max_bytes(other._storage.reserved_bytes()).aligned_to(alignment(other._storage, 0));
+  }
+
+  template<typename S>
+  static auto commits_zeroed_pages(S const& storage, int) noexcept -> decltype(storage.commits_zeroed_pages())
+  {
+    return storage.commits_zeroed_pages();
+  }
+  template<typename S>
+  static auto commits_zeroed_pages(S const&, long) noexcept -> bool
+  {
+    return false;
+  }
+  // Value-initialize new elements until there are count of them. Pages committed on the way are not written to again
+  // if the system already zeroed them.
+  auto value_construct_until(size_type count) -> void
+  {
+    auto const old_committed_bytes = _storage.committed_bytes();
+    reserve(count);
+    auto const* const zeroed = commits_zeroed_pages(_storage, 0)
+                                 ? reinterpret_cast<char const*>(data()) + old_committed_bytes
+                                 : nullptr;
+    _end = detail::uninitialized_value_construct_contiguous_n(_end.value, count - size(), zeroed);
+  }
+
   auto grow_if_necessary(std::size_t n) -> void
   {
     assert(max_size() - size() >= n);
     auto const new_size = size() + n;
+    assert_mutable();
     if(new_size > capacity())
     {
       auto const new_cap = capacity() * Traits::growth_factor::num / Traits::growth_factor::den;
@@ -442,6 +784,60 @@ private:
   detail::value_init_when_moved_from<T*> _end = data();
 };
 
+///////////////////////////////////////////////////////////////////////////////
+// pinned_snapshot
+//
+
+// Read-only view of the elements of a pinned_vector at the time of pinned_vector::snapshot().
+template<typename T, typename Snapshot>
+class mknejp::vmcontainer::pinned_snapshot
+{
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using const_reference = T const&;
+  using const_pointer = T const*;
+  using const_iterator = T const*;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  using snapshot_type = Snapshot;
+
+  pinned_snapshot() = default;
+  pinned_snapshot(Snapshot snapshot, size_type size) noexcept : _snapshot(std::move(snapshot)), _size(size) {}
+
+  auto operator[](size_type pos) const -> T const&
+  {
+    assert(pos < size());
+    return data()[pos];
+  }
+  auto front() const -> T const&
+  {
+    assert(size() > 0);
+    return (*this)[0];
+  }
+  auto back() const -> T const&
+  {
+    assert(size() > 0);
+    return (*this)[size() - 1];
+  }
+  auto data() const noexcept -> T const* { return static_cast<T const*>(_snapshot.base()); }
+
+  auto begin() const noexcept -> const_iterator { return data(); }
+  auto end() const noexcept -> const_iterator { return data() + size(); }
+  auto cbegin() const noexcept -> const_iterator { return begin(); }
+  auto cend() const noexcept -> const_iterator { return end(); }
+  auto rbegin() const noexcept -> const_reverse_iterator { return const_reverse_iterator(end()); }
+  auto rend() const noexcept -> const_reverse_iterator { return const_reverse_iterator(begin()); }
+
+  auto empty() const noexcept -> bool { return size() == 0; }
+  auto size() const noexcept -> size_type { return _size; }
+
+private:
+  Snapshot _snapshot;
+  detail::value_init_when_moved_from<size_type> _size = 0;
+};
+
 namespace mknejp
 {
   namespace vmcontainer
@@ -0,0 +1,82 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+#include "vmcontainer/detail.hpp"
+#include "vmcontainer/vm.hpp"
+
+#include <cstddef>
+
+namespace mknejp
+{
+  namespace vmcontainer
+  {
+    namespace vm
+    {
+      class realtime_thread_scope;
+      class realtime_page_stack;
+
+      auto is_realtime_thread() noexcept -> bool;
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// realtime_thread_scope
+//
+
+// Tags the current thread as real-time for the lifetime of the object. In debug builds every call into
+// vm::system_default asserts that the calling thread is not tagged. Scopes can be nested.
+class mknejp::vmcontainer::vm::realtime_thread_scope
+{
+public:
+  realtime_thread_scope() noexcept;
+  realtime_thread_scope(realtime_thread_scope const&) = delete;
+  auto operator=(realtime_thread_scope const&) -> realtime_thread_scope& = delete;
+  ~realtime_thread_scope();
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// realtime_page_stack
+//
+
+// A page stack that commits and locks its whole reservation up front, so the working set of a container is its
+// max_size(). resize() and append_pages_from() only move the boundary of the used pages and never enter the kernel,
+// which makes growing, shrinking and relocating elements within the reservation safe on real-time threads.
+// Construction, try_extend() and destruction do make system calls and belong on other threads.
+class mknejp::vmcontainer::vm::realtime_page_stack
+{
+public:
+  realtime_page_stack() = default;
+  // Throws std::system_error if the pages cannot be locked, for example because of RLIMIT_MEMLOCK.
+  explicit realtime_page_stack(reservation_size_t reserved_bytes);
+
+  // Throws std::bad_alloc if new_bytes exceeds the working set.
+  auto resize(std::size_t new_bytes) -> std::size_t;
+  // Commits and locks the new pages.
+  auto try_extend(reservation_size_t reserved_bytes) -> bool;
+  // Copies the pages since the destination is already committed.
+  auto append_pages_from(realtime_page_stack& source, std::size_t offset) -> void;
+
+  auto residency() const -> page_residency { return residency(0, committed_bytes()); }
+  auto residency(std::size_t offset, std::size_t num_bytes) const -> page_residency;
+
+  auto base() const noexcept -> void* { return _reservation.base(); }
+  auto committed_bytes() const noexcept -> std::size_t { return _committed_bytes; }
+  auto reserved_bytes() const noexcept -> std::size_t { return _reservation.reserved_bytes(); }
+  auto alignment() const noexcept -> std::size_t { return _reservation.alignment(); }
+  auto page_size() const noexcept -> std::size_t { return system_default::page_size(); }
+  // The bytes committed and locked, always the whole reservation.
+  auto locked_bytes() const noexcept -> std::size_t { return _locked_bytes; }
+
+private:
+  auto lock(std::size_t num_bytes) -> void;
+
+  reservation _reservation;
+  // Pages handed out through resize(), all of them lie inside the locked range.
+  detail::value_init_when_moved_from<std::size_t> _committed_bytes = 0;
+  detail::value_init_when_moved_from<std::size_t> _locked_bytes = 0;
+};
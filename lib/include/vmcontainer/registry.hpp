@@ -0,0 +1,217 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+#include "vmcontainer/detail.hpp"
+#include "vmcontainer/vm.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace mknejp
+{
+  namespace vmcontainer
+  {
+    namespace vm
+    {
+      struct trim_policy;
+      struct registry_stats;
+      class page_stack_registry;
+
+      template<typename VirtualMemorySystem = system_default>
+      class registered_page_stack;
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// page_stack_registry
+//
+
+struct mknejp::vmcontainer::vm::trim_policy
+{
+  // Slack to keep committed behind the used bytes of every stack, rounded up to whole pages.
+  std::size_t retained_slack_bytes = 0;
+  // Stacks that would release fewer bytes than this are left alone.
+  std::size_t min_trimmed_bytes = 0;
+};
+
+struct mknejp::vmcontainer::vm::registry_stats
+{
+  std::size_t num_stacks = 0;
+  std::size_t committed_bytes = 0;
+  std::size_t used_bytes = 0;
+};
+
+// Process-wide list of all live registered_page_stack instances so slack capacity can be reclaimed under memory
+// pressure from containers the caller has no reference to.
+class mknejp::vmcontainer::vm::page_stack_registry
+{
+public:
+  static constexpr std::size_t no_trim_request = std::numeric_limits<std::size_t>::max();
+
+  // Shared between a registered_page_stack and the registry. Only the thread owning the stack commits or decommits
+  // its pages, the registry only reads the counters and posts trim requests.
+  struct entry
+  {
+    std::atomic<std::size_t> committed_bytes = {0};
+    std::atomic<std::size_t> used_bytes = {0};
+    // The slack to keep at the next mutation, or no_trim_request.
+    std::atomic<std::size_t> trim_request = {no_trim_request};
+    std::size_t page_size = 0;
+    entry* prev = nullptr;
+    entry* next = nullptr;
+  };
+
+  static auto instance() -> page_stack_registry&;
+
+  // Ask every registered stack to decommit its pages beyond the used bytes plus policy.retained_slack_bytes.
+  // The owning thread decommits them at the next mutation of the container, so idle containers keep their pages until
+  // then. Returns the number of bytes expected to be released.
+  auto trim_all(trim_policy policy = trim_policy()) -> std::size_t;
+  auto stats() const -> registry_stats;
+
+  auto add(entry& e) noexcept -> void;
+  auto remove(entry& e) noexcept -> void;
+
+private:
+  mutable std::mutex _mutex;
+  entry* _first = nullptr;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// registered_page_stack
+//
+
+// A page stack that is listed in page_stack_registry::instance() for as long as it owns a reservation.
+// Containers report their used bytes through note_used() when they change size, which is also where trim requests
+// posted by page_stack_registry::trim_all() are honoured.
+template<typename VirtualMemorySystem>
+class mknejp::vmcontainer::vm::registered_page_stack
+{
+public:
+  using vm_system_type = VirtualMemorySystem;
+
+  registered_page_stack() = default;
+  explicit registered_page_stack(reservation_size_t reserved_bytes) : _pages(reserved_bytes) { register_pages(); }
+  registered_page_stack(reservation_size_t reserved_bytes, VirtualMemorySystem vm_system)
+    : _pages(reserved_bytes, std::move(vm_system))
+  {
+    register_pages();
+  }
+
+  auto resize(std::size_t new_bytes) -> std::size_t
+  {
+    _pages.resize(new_bytes);
+    update_committed_bytes();
+    return committed_bytes();
+  }
+  auto try_extend(reservation_size_t reserved_bytes) -> bool
+  {
+    if(!_pages.try_extend(reserved_bytes))
+    {
+      return false;
+    }
+    if(!_entry)
+    {
+      register_pages();
+    }
+    return true;
+  }
+  auto append_pages_from(registered_page_stack& source, std::size_t offset) -> void
+  {
+    _pages.append_pages_from(source._pages, offset);
+    source.update_committed_bytes();
+    update_committed_bytes();
+  }
+
+  // Record that the first used_bytes are in use and decommit the slack behind them if a trim has been requested.
+  auto note_used(std::size_t used_bytes) noexcept -> void
+  {
+    if(!_entry)
+    {
+      return;
+    }
+    _entry->used_bytes.store(used_bytes, std::memory_order_relaxed);
+    if(_entry->trim_request.load(std::memory_order_relaxed) != page_stack_registry::no_trim_request)
+    {
+      auto const retained = _entry->trim_request.exchange(page_stack_registry::no_trim_request);
+      auto const slack = committed_bytes() - std::min(used_bytes, committed_bytes());
+      if(retained < slack)
+      {
+        try
+        {
+          resize(used_bytes + retained);
+        }
+        catch(...)
+        {
+          // Trimming is best effort, the pages stay committed.
+        }
+      }
+    }
+  }
+
+  auto residency() const -> page_residency { return _pages.residency(); }
+  auto residency(std::size_t offset, std::size_t num_bytes) const -> page_residency
+  {
+    return _pages.residency(offset, num_bytes);
+  }
+
+  auto advise(std::size_t offset, std::size_t num_bytes, access_hint hint) -> bool
+  {
+    return _pages.advise(offset, num_bytes, hint);
+  }
+
+  auto base() const noexcept -> void* { return _pages.base(); }
+  auto committed_bytes() const noexcept -> std::size_t { return _pages.committed_bytes(); }
+  auto reserved_bytes() const noexcept -> std::size_t { return _pages.reserved_bytes(); }
+  auto alignment() const noexcept -> std::size_t { return _pages.alignment(); }
+  auto commits_zeroed_pages() const noexcept -> bool { return _pages.commits_zeroed_pages(); }
+  auto page_size() const noexcept -> std::size_t { return _pages.page_size(); }
+
+  auto vm_system() noexcept -> VirtualMemorySystem& { return _pages.vm_system(); }
+  auto vm_system() const noexcept -> VirtualMemorySystem const& { return _pages.vm_system(); }
+
+private:
+  struct unregister
+  {
+    auto operator()(page_stack_registry::entry* e) const noexcept -> void
+    {
+      page_stack_registry::instance().remove(*e);
+      delete e;
+    }
+  };
+
+  auto register_pages() -> void
+  {
+    if(base() != nullptr)
+    {
+      _entry.reset(new page_stack_registry::entry());
+      _entry->page_size = page_size();
+      update_committed_bytes();
+      page_stack_registry::instance().add(*_entry);
+    }
+  }
+  auto update_committed_bytes() noexcept -> void
+  {
+    if(_entry)
+    {
+      _entry->committed_bytes.store(committed_bytes(), std::memory_order_relaxed);
+      if(_entry->used_bytes.load(std::memory_order_relaxed) > committed_bytes())
+      {
+        _entry->used_bytes.store(committed_bytes(), std::memory_order_relaxed);
+      }
+    }
+  }
+
+  page_stack_base<VirtualMemorySystem> _pages;
+  std::unique_ptr<page_stack_registry::entry, unregister> _entry;
+};
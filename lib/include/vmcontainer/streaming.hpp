@@ -0,0 +1,186 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+#include "vmcontainer/detail.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+
+// Fills and copies of trivially copyable data of at least this many bytes bypass the cache, see stream_fill().
+// Should be in the order of the last level cache size, zero disables streaming stores. Fills only stream if sizeof(T)
+// divides 32, see can_stream_fill(), so types of 12, 24 or 48 bytes for example are always filled through the cache.
+#ifndef VMCONTAINER_STREAMING_THRESHOLD
+#  define VMCONTAINER_STREAMING_THRESHOLD (8 * 1024 * 1024)
+#endif
+
+namespace mknejp
+{
+  namespace vmcontainer
+  {
+    namespace detail
+    {
+      // Copy num_bytes from src to dest with non-temporal stores so the destination does not evict the cache.
+      auto stream_copy(void* dest, void const* src, std::size_t num_bytes) noexcept -> void;
+      // Fill num_bytes at dest with repetitions of pattern using non-temporal stores. pattern_size must satisfy
+      // can_stream_fill(), num_bytes must be a multiple of it.
+      auto stream_fill(void* dest, void const* pattern, std::size_t pattern_size, std::size_t num_bytes) noexcept
+        -> void;
+      constexpr auto can_stream_fill(std::size_t pattern_size) noexcept -> bool;
+
+      // Equivalent to the algorithms of the same name in std but use streaming stores for large ranges of trivially
+      // copyable types.
+      template<typename T>
+      auto fill_n(T* first, std::size_t count, T const& value) -> T*;
+      template<typename T>
+      auto uninitialized_fill_n(T* first, std::size_t count, T const& value) -> T*;
+      template<typename InputIt, typename T>
+      auto copy(InputIt first, InputIt last, T* d_first) -> T*;
+      template<typename InputIt, typename T>
+      auto uninitialized_copy(InputIt first, InputIt last, T* d_first) -> T*;
+      // Like uninitialized_value_construct_n() in detail.hpp but restricted to contiguous storage. The bytes from
+      // zeroed on are known to be zero, like pages the system just committed, and trivial elements whose
+      // value-initialized representation is all zero bytes are not written there.
+      template<typename T>
+      auto uninitialized_value_construct_contiguous_n(T* first, std::size_t count, void const* zeroed = nullptr) -> T*;
+      template<typename T>
+      auto is_zero_when_value_initialized(std::true_type) noexcept -> bool;
+      template<typename T>
+      auto is_zero_when_value_initialized(std::false_type) noexcept -> bool
+      {
+        return false;
+      }
+
+      template<typename T>
+      constexpr auto use_streaming_stores(std::size_t count) noexcept -> bool;
+
+      template<typename InputIt, typename T>
+      using is_contiguous_range_of = std::integral_constant<
+        bool,
+        std::is_pointer<InputIt>::value
+          && std::is_same<typename std::remove_cv<typename std::remove_pointer<InputIt>::type>::type, T>::value>;
+      // Returns the end of the copied range or nullptr if the range is too small to stream.
+      template<typename T>
+      auto try_stream_copy(T const* first, T const* last, T* d_first, std::true_type) noexcept -> T*;
+      template<typename InputIt, typename T>
+      auto try_stream_copy(InputIt, InputIt, T*, std::false_type) noexcept -> T*
+      {
+        return nullptr;
+      }
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// streaming stores
+//
+
+constexpr auto mknejp::vmcontainer::detail::can_stream_fill(std::size_t pattern_size) noexcept -> bool
+{
+  // The pattern must tile a vector register.
+  return pattern_size > 0 && pattern_size <= 32 && 32 % pattern_size == 0;
+}
+
+template<typename T>
+constexpr auto mknejp::vmcontainer::detail::use_streaming_stores(std::size_t count) noexcept -> bool
+{
+  return std::is_trivially_copyable<T>::value && VMCONTAINER_STREAMING_THRESHOLD > 0
+         && count >= VMCONTAINER_STREAMING_THRESHOLD / sizeof(T);
+}
+
+template<typename T>
+auto mknejp::vmcontainer::detail::fill_n(T* first, std::size_t count, T const& value) -> T*
+{
+  if(use_streaming_stores<T>(count) && can_stream_fill(sizeof(T)))
+  {
+    detail::stream_fill(first, std::addressof(value), sizeof(T), count * sizeof(T));
+    return first + count;
+  }
+  return std::fill_n(first, count, value);
+}
+
+template<typename T>
+auto mknejp::vmcontainer::detail::uninitialized_fill_n(T* first, std::size_t count, T const& value) -> T*
+{
+  // Trivially copyable objects can be created by copying their bytes.
+  if(use_streaming_stores<T>(count) && can_stream_fill(sizeof(T)))
+  {
+    detail::stream_fill(first, std::addressof(value), sizeof(T), count * sizeof(T));
+    return first + count;
+  }
+  return std::uninitialized_fill_n(first, count, value);
+}
+
+template<typename InputIt, typename T>
+auto mknejp::vmcontainer::detail::copy(InputIt first, InputIt last, T* d_first) -> T*
+{
+  if(auto* const d_last = detail::try_stream_copy(first, last, d_first, is_contiguous_range_of<InputIt, T>()))
+  {
+    return d_last;
+  }
+  return std::copy(first, last, d_first);
+}
+
+template<typename InputIt, typename T>
+auto mknejp::vmcontainer::detail::uninitialized_copy(InputIt first, InputIt last, T* d_first) -> T*
+{
+  // Trivially copyable objects can be created by copying their bytes.
+  if(auto* const d_last = detail::try_stream_copy(first, last, d_first, is_contiguous_range_of<InputIt, T>()))
+  {
+    return d_last;
+  }
+  return std::uninitialized_copy(first, last, d_first);
+}
+
+template<typename T>
+auto mknejp::vmcontainer::detail::uninitialized_value_construct_contiguous_n(T* first,
+                                                                            std::size_t count,
+                                                                            void const* zeroed) -> T*
+{
+  if(zeroed != nullptr && is_zero_when_value_initialized<T>(std::is_trivial<T>()))
+  {
+    // Trivial objects made of zero bytes already hold their value-initialized value, only the ones before zeroed
+    // need to be written.
+    auto const* const p = reinterpret_cast<char const*>(first);
+    auto const dirty_bytes = static_cast<std::size_t>(std::max(static_cast<char const*>(zeroed), p) - p);
+    auto const num_dirty = std::min(count, detail::round_up(dirty_bytes, sizeof(T)) / sizeof(T));
+    detail::uninitialized_value_construct_contiguous_n(first, num_dirty);
+    return first + count;
+  }
+  // Value-initializing a trivial type has no side effects, so all elements can be copies of one.
+  if(std::is_trivial<T>::value && use_streaming_stores<T>(count) && can_stream_fill(sizeof(T)))
+  {
+    T const value{};
+    detail::stream_fill(first, std::addressof(value), sizeof(T), count * sizeof(T));
+    return first + count;
+  }
+  return detail::uninitialized_value_construct_n(first, count);
+}
+
+template<typename T>
+auto mknejp::vmcontainer::detail::is_zero_when_value_initialized(std::true_type) noexcept -> bool
+{
+  T const value{};
+  unsigned char const zeros[sizeof(T)] = {};
+  return std::memcmp(std::addressof(value), zeros, sizeof(T)) == 0;
+}
+
+template<typename T>
+auto mknejp::vmcontainer::detail::try_stream_copy(T const* first, T const* last, T* d_first, std::true_type) noexcept
+  -> T*
+{
+  auto const count = static_cast<std::size_t>(last - first);
+  if(use_streaming_stores<T>(count))
+  {
+    detail::stream_copy(d_first, first, count * sizeof(T));
+    return d_first + count;
+  }
+  return nullptr;
+}
@@ -0,0 +1,137 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+#include "vmcontainer/vm.hpp"
+
+#include <cstddef>
+#include <utility>
+
+namespace mknejp
+{
+  namespace vmcontainer
+  {
+    namespace vm
+    {
+      template<typename VirtualMemorySystem>
+      class system_wrapper;
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// system_wrapper
+//
+
+// Base of the virtual memory systems that add behavior to another one. Forwards every operation to the wrapped
+// system, derived systems hide the ones they intercept and reach the wrapped system through inner().
+//
+// The optional operations (discard(), lock(), set_fork_behavior(), set_read_only(), etc.) only exist if the wrapped
+// system provides them, so wrappers can be stacked in any order, for example
+// tagged_system<fork_policy_system<budgeted_system<>>>.
+template<typename VirtualMemorySystem>
+class mknejp::vmcontainer::vm::system_wrapper : private VirtualMemorySystem
+{
+public:
+  using wrapped_system_type = VirtualMemorySystem;
+
+  system_wrapper() = default;
+  explicit system_wrapper(VirtualMemorySystem system) noexcept : VirtualMemorySystem(std::move(system)) {}
+
+  auto reserve(std::size_t num_bytes) -> void* { return inner().reserve(num_bytes); }
+  auto reserve_aligned(std::size_t num_bytes, std::size_t alignment) -> void*
+  {
+    return inner().reserve_aligned(num_bytes, alignment);
+  }
+  auto reserve_at(void* address, std::size_t num_bytes) -> void* { return inner().reserve_at(address, num_bytes); }
+  auto extend(void* offset, std::size_t num_bytes) -> bool { return inner().extend(offset, num_bytes); }
+  auto free(void* offset, std::size_t num_bytes) -> void { inner().free(offset, num_bytes); }
+  auto commit(void* offset, std::size_t num_bytes) -> void { inner().commit(offset, num_bytes); }
+  auto decommit(void* offset, std::size_t num_bytes) -> void { inner().decommit(offset, num_bytes); }
+  auto move_pages(void* from, void* to, std::size_t num_bytes) -> void { inner().move_pages(from, to, num_bytes); }
+  auto residency(void const* offset, std::size_t num_bytes) const -> page_residency
+  {
+    return inner().residency(offset, num_bytes);
+  }
+  auto advise(void* offset, std::size_t num_bytes, access_hint hint) -> bool
+  {
+    return inner().advise(offset, num_bytes, hint);
+  }
+  auto page_size() const noexcept -> std::size_t { return inner().page_size(); }
+
+  // Wrappers that change the contents of committed pages must hide this.
+  template<typename S = VirtualMemorySystem>
+  auto commits_zeroed_pages() const noexcept -> decltype(std::declval<S const&>().commits_zeroed_pages())
+  {
+    return inner().commits_zeroed_pages();
+  }
+  template<typename S = VirtualMemorySystem>
+  auto discard(void* offset, std::size_t num_bytes) noexcept -> decltype(std::declval<S&>().discard(offset, num_bytes))
+  {
+    return inner().discard(offset, num_bytes);
+  }
+  template<typename S = VirtualMemorySystem>
+  auto lock(void* offset, std::size_t num_bytes) -> decltype(std::declval<S&>().lock(offset, num_bytes))
+  {
+    return inner().lock(offset, num_bytes);
+  }
+  template<typename S = VirtualMemorySystem>
+  auto unlock(void* offset, std::size_t num_bytes) -> decltype(std::declval<S&>().unlock(offset, num_bytes))
+  {
+    return inner().unlock(offset, num_bytes);
+  }
+  template<typename S = VirtualMemorySystem>
+  auto set_fork_behavior(void* offset, std::size_t num_bytes, fork_behavior behavior)
+    -> decltype(std::declval<S&>().set_fork_behavior(offset, num_bytes, behavior))
+  {
+    return inner().set_fork_behavior(offset, num_bytes, behavior);
+  }
+  template<typename S = VirtualMemorySystem>
+  auto set_dumpable(void* offset, std::size_t num_bytes, bool dumpable)
+    -> decltype(std::declval<S&>().set_dumpable(offset, num_bytes, dumpable))
+  {
+    return inner().set_dumpable(offset, num_bytes, dumpable);
+  }
+  template<typename S = VirtualMemorySystem>
+  auto set_name(void* offset, std::size_t num_bytes, char const* name)
+    -> decltype(std::declval<S&>().set_name(offset, num_bytes, name))
+  {
+    return inner().set_name(offset, num_bytes, name);
+  }
+  template<typename S = VirtualMemorySystem>
+  auto set_read_only(void* offset, std::size_t num_bytes, bool read_only)
+    -> decltype(std::declval<S&>().set_read_only(offset, num_bytes, read_only))
+  {
+    return inner().set_read_only(offset, num_bytes, read_only);
+  }
+  template<typename S = VirtualMemorySystem>
+  auto set_mergeable(void* offset, std::size_t num_bytes, bool mergeable)
+    -> decltype(std::declval<S&>().set_mergeable(offset, num_bytes, mergeable))
+  {
+    return inner().set_mergeable(offset, num_bytes, mergeable);
+  }
+
+  auto inner() noexcept -> VirtualMemorySystem& { return *this; }
+  auto inner() const noexcept -> VirtualMemorySystem const& { return *this; }
+
+protected:
+  // For derived systems that intercept discard(). Forwards if the wrapped system accounts for committed pages.
+  auto discard_inner(void* offset, std::size_t num_bytes) noexcept -> void
+  {
+    forward_discard(inner(), offset, num_bytes, 0);
+  }
+
+private:
+  template<typename VMS>
+  static auto forward_discard(VMS& vms, void* offset, std::size_t num_bytes, int) noexcept
+    -> decltype(vms.discard(offset, num_bytes))
+  {
+    vms.discard(offset, num_bytes);
+  }
+  template<typename VMS>
+  static auto forward_discard(VMS&, void*, std::size_t, long) noexcept -> void
+  {}
+};
@@ -7,8 +7,11 @@
 #pragma once
 #include "vmcontainer/detail.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <memory>
 
 namespace mknejp
@@ -18,6 +21,9 @@ namespace mknejp
     namespace vm
     {
       struct system_default;
+      struct page_residency;
+      enum class fork_behavior;
+      enum class access_hint;
 
       class reservation;
       template<typename VirtualMemorySystem>
@@ -30,6 +36,56 @@ namespace mknejp
   }
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// page_residency
+//
+
+// Page counts of a range of committed memory. Committed pages need not be resident under overcommit.
+struct mknejp::vmcontainer::vm::page_residency
+{
+  // Pages currently in physical memory.
+  std::size_t resident_pages = 0;
+  // Pages that have been accessed at least once, including those swapped out since.
+  std::size_t touched_pages = 0;
+  // Resident pages that are part of a transparent huge page.
+  std::size_t huge_pages = 0;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// fork_behavior
+//
+
+// What a child process created with fork() sees of a reservation.
+enum class mknejp::vmcontainer::vm::fork_behavior
+{
+  // The child gets a copy-on-write copy of the committed pages.
+  copy,
+  // The reservation is not mapped in the child. Forking skips its page tables entirely.
+  dont_fork,
+  // The reservation is mapped in the child but all committed pages read as zero.
+  wipe,
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// access_hint
+//
+
+// How a range of committed pages is going to be accessed.
+enum class mknejp::vmcontainer::vm::access_hint
+{
+  normal,
+  // Read ahead aggressively and drop pages soon after they were accessed.
+  sequential,
+  // Do not read ahead.
+  random,
+  // The pages are needed soon, start bringing them in.
+  will_need,
+  // The pages are not needed for a while, reclaim them before others under memory pressure.
+  cold,
+  // The pages are not needed for a while, reclaim them now. The contents are preserved.
+  page_out,
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 // default_vm_traits
 //
@@ -37,11 +93,47 @@ namespace mknejp
 struct mknejp::vmcontainer::vm::system_default
 {
   static auto reserve(std::size_t num_bytes) -> void*;
+  // Reserve num_bytes at an address that is a multiple of alignment, a power of two larger than the page size.
+  static auto reserve_aligned(std::size_t num_bytes, std::size_t alignment) -> void*;
+  // Reserve exactly [address, address + num_bytes). Never replaces existing mappings, instead throws std::system_error
+  // with std::errc::file_exists if any part of the range is already in use.
+  static auto reserve_at(void* address, std::size_t num_bytes) -> void*;
+  // Try to reserve the num_bytes immediately following offset so they become part of the same reservation.
+  // Returns false if the address range is already in use or the system cannot extend reservations in place.
+  static auto extend(void* offset, std::size_t num_bytes) -> bool;
   static auto free(void* offset, std::size_t num_bytes) -> void;
   static auto commit(void* offset, std::size_t num_bytes) -> void;
   static auto decommit(void* offset, std::size_t num_bytes) -> void;
+  // Move the committed pages at [from, from + num_bytes) to the reserved but uncommitted pages at [to, to + num_bytes).
+  // Afterwards the source pages are decommitted. Remaps the pages where supported, otherwise copies their contents.
+  static auto move_pages(void* from, void* to, std::size_t num_bytes) -> void;
+  // Count the resident pages in [offset, offset + num_bytes) with mincore(). Touched and huge pages are taken from
+  // /proc/self/pagemap and /proc/self/smaps where available, otherwise they are reported as resident and 0.
+  static auto residency(void const* offset, std::size_t num_bytes) -> page_residency;
+  // Lock the committed pages in [offset, offset + num_bytes) into physical memory, faulting them in first.
+  // Throws std::system_error if the pages cannot be locked, for example because of RLIMIT_MEMLOCK.
+  static auto lock(void* offset, std::size_t num_bytes) -> void;
+  static auto unlock(void* offset, std::size_t num_bytes) -> void;
+  // Throws std::system_error with std::errc::not_supported if the platform cannot provide the behavior.
+  static auto set_fork_behavior(void* offset, std::size_t num_bytes, fork_behavior behavior) -> void;
+  // Include or exclude [offset, offset + num_bytes) from core dumps. Excluding throws std::system_error with
+  // std::errc::not_supported if the platform has no way to do so.
+  static auto set_dumpable(void* offset, std::size_t num_bytes, bool dumpable) -> void;
+  // Show [offset, offset + num_bytes) as [anon:name] in /proc/self/maps. Returns false if the platform or kernel does
+  // not support naming memory or rejects the name. The name is copied.
+  static auto set_name(void* offset, std::size_t num_bytes, char const* name) noexcept -> bool;
+  // Switch the committed pages in [offset, offset + num_bytes) between read-only and read-write.
+  static auto set_read_only(void* offset, std::size_t num_bytes, bool read_only) -> void;
+  // Allow or forbid the kernel to merge identical pages in [offset, offset + num_bytes) with those of other processes
+  // (Linux KSM). Returns false if page merging is not supported.
+  static auto set_mergeable(void* offset, std::size_t num_bytes, bool mergeable) noexcept -> bool;
+  // Tell the system how [offset, offset + num_bytes) is going to be accessed. offset must be a multiple of the page
+  // size. Returns false if the platform or kernel does not support the hint.
+  static auto advise(void* offset, std::size_t num_bytes, access_hint hint) noexcept -> bool;
 
   static auto page_size() noexcept -> std::size_t { return _page_size; }
+  // Committed pages read as zero until written, also when they were committed and decommitted before.
+  static constexpr auto commits_zeroed_pages() noexcept -> bool { return true; }
 
 private:
   static std::size_t const _page_size;
@@ -51,35 +143,135 @@ private:
 // reservation
 //
 
+// VirtualMemorySystem may be stateful, for example to direct reservations to an arena or count them. The reservation
+// stores a copy of it and routes all calls through that copy. Stateless systems like system_default take no space.
 template<typename VirtualMemorySystem>
 class mknejp::vmcontainer::vm::reservation_base
 {
 public:
+  using vm_system_type = VirtualMemorySystem;
+
   reservation_base() = default;
-  explicit reservation_base(reservation_size_t reserved_bytes)
+  explicit reservation_base(VirtualMemorySystem vm_system) noexcept
+    : _reservation(nullptr, deleter(std::move(vm_system)))
+  {}
+  explicit reservation_base(reservation_size_t reserved_bytes) : reservation_base(reserved_bytes, VirtualMemorySystem())
+  {}
+  reservation_base(reservation_size_t reserved_bytes, VirtualMemorySystem vm_system)
+    : reservation_base(std::move(vm_system))
   {
-    auto num_bytes = reserved_bytes.num_bytes(VirtualMemorySystem::page_size());
+    auto& vms = this->vm_system();
+    auto num_bytes = reserved_bytes.num_bytes(vms.page_size());
     if(num_bytes > 0)
     {
-      num_bytes = detail::round_up(num_bytes, VirtualMemorySystem::page_size());
-      _reservation.reset(VirtualMemorySystem::reserve(num_bytes));
-      _reservation.get_deleter().reserved_bytes = num_bytes;
+      num_bytes = detail::round_up(num_bytes, vms.page_size());
+      auto const alignment = reserved_bytes.alignment(vms.page_size());
+      _reservation.reset(alignment > vms.page_size() ? vms.reserve_aligned(num_bytes, alignment)
+                                                     : vms.reserve(num_bytes));
+      _reservation.get_deleter().set(num_bytes, alignment > vms.page_size() ? log2(alignment) : 0);
     }
   }
 
+  // Reserve at the fixed address, which must be a multiple of the page size.
+  // Throws std::system_error if the address range is already in use.
+  reservation_base(void* address, reservation_size_t reserved_bytes)
+    : reservation_base(address, reserved_bytes, VirtualMemorySystem())
+  {}
+  reservation_base(void* address, reservation_size_t reserved_bytes, VirtualMemorySystem vm_system)
+    : reservation_base(std::move(vm_system))
+  {
+    auto& vms = this->vm_system();
+    assert(reinterpret_cast<std::uintptr_t>(address) % vms.page_size() == 0);
+    auto num_bytes = reserved_bytes.num_bytes(vms.page_size());
+    if(num_bytes > 0)
+    {
+      num_bytes = detail::round_up(num_bytes, vms.page_size());
+      _reservation.reset(vms.reserve_at(address, num_bytes));
+      _reservation.get_deleter().set(num_bytes, 0);
+    }
+  }
+
+  // Grow the reservation to at least reserved_bytes without changing base().
+  // Returns false and leaves the reservation untouched if the address space after the reservation is taken.
+  auto try_extend(reservation_size_t reserved_bytes) -> bool
+  {
+    auto& vms = vm_system();
+    auto const num_bytes = detail::round_up(reserved_bytes.num_bytes(vms.page_size()), vms.page_size());
+    if(num_bytes <= this->reserved_bytes())
+    {
+      return true;
+    }
+    if(base() == nullptr)
+    {
+      // Nothing is pinned yet so any address will do.
+      *this = reservation_base(reserved_bytes, vms);
+      return true;
+    }
+    if(!vms.extend(static_cast<char*>(base()) + this->reserved_bytes(), num_bytes - this->reserved_bytes()))
+    {
+      return false;
+    }
+    _reservation.get_deleter().set(num_bytes, _reservation.get_deleter().alignment_log2());
+    return true;
+  }
+
   auto base() const noexcept -> void* { return _reservation.get(); }
-  auto reserved_bytes() const noexcept -> std::size_t { return _reservation.get_deleter().reserved_bytes; }
+  auto reserved_bytes() const noexcept -> std::size_t { return _reservation.get_deleter().num_bytes(); }
+  // The alignment requested for base(), at least the page size. Only remembered where std::size_t has 64 bits.
+  auto alignment() const noexcept -> std::size_t
+  {
+    auto const alignment_log2 = _reservation.get_deleter().alignment_log2();
+    return alignment_log2 > 0 ? std::size_t(1) << alignment_log2 : vm_system().page_size();
+  }
+
+  auto vm_system() noexcept -> VirtualMemorySystem& { return _reservation.get_deleter(); }
+  auto vm_system() const noexcept -> VirtualMemorySystem const& { return _reservation.get_deleter(); }
 
 private:
-  struct deleter
+  // Derives from VirtualMemorySystem so stateless systems occupy no space.
+  struct deleter : VirtualMemorySystem
   {
-    auto operator()(void* p) const -> void { VirtualMemorySystem::free(p, reserved_bytes); }
-    detail::value_init_when_moved_from<std::size_t> reserved_bytes = 0;
+    deleter() = default;
+    explicit deleter(VirtualMemorySystem vm_system) noexcept : VirtualMemorySystem(std::move(vm_system)) {}
+
+    auto operator()(void* p) -> void { this->free(p, num_bytes()); }
+
+    // No address space is large enough to need the top bits of the reserved bytes, they hold log2 of the alignment
+    // requested beyond the page size so it takes no extra space.
+    auto num_bytes() const noexcept -> std::size_t { return bits & ~alignment_mask; }
+    auto alignment_log2() const noexcept -> std::size_t { return (bits & alignment_mask) >> alignment_shift; }
+    auto set(std::size_t num_bytes, std::size_t alignment_log2) noexcept -> void
+    {
+      assert((num_bytes & alignment_mask) == 0);
+      bits = num_bytes | ((alignment_log2 << alignment_shift) & alignment_mask);
+    }
+
+    detail::value_init_when_moved_from<std::size_t> bits = 0;
   };
 
+  static constexpr std::size_t alignment_shift = std::numeric_limits<std::size_t>::digits - 6;
+  static constexpr std::size_t alignment_mask =
+    std::numeric_limits<std::size_t>::digits >= 64 ? std::size_t(63) << alignment_shift : 0;
+
+  static auto log2(std::size_t alignment) noexcept -> std::size_t
+  {
+    auto result = std::size_t(0);
+    while(alignment > 1)
+    {
+      alignment >>= 1;
+      ++result;
+    }
+    return result;
+  }
+
   std::unique_ptr<void, deleter> _reservation;
 };
 
+template<typename VirtualMemorySystem>
+constexpr std::size_t mknejp::vmcontainer::vm::reservation_base<VirtualMemorySystem>::alignment_shift;
+template<typename VirtualMemorySystem>
+constexpr std::size_t mknejp::vmcontainer::vm::reservation_base<VirtualMemorySystem>::alignment_mask;
+
 class mknejp::vmcontainer::vm::reservation final : public reservation_base<system_default>
 {
   using reservation_base<system_default>::reservation_base;
@@ -93,35 +285,197 @@ template<typename VirtualMemorySystem>
 class mknejp::vmcontainer::vm::page_stack_base
 {
 public:
+  using vm_system_type = VirtualMemorySystem;
+
   page_stack_base() = default;
+  explicit page_stack_base(VirtualMemorySystem vm_system) noexcept : _reservation(std::move(vm_system)) {}
   explicit page_stack_base(reservation_size_t reserved_bytes) : _reservation(reserved_bytes) {}
+  page_stack_base(reservation_size_t reserved_bytes, VirtualMemorySystem vm_system)
+    : _reservation(reserved_bytes, std::move(vm_system))
+  {}
+  page_stack_base(void* address, reservation_size_t reserved_bytes) : _reservation(address, reserved_bytes) {}
+  page_stack_base(void* address, reservation_size_t reserved_bytes, VirtualMemorySystem vm_system)
+    : _reservation(address, reserved_bytes, std::move(vm_system))
+  {}
   explicit page_stack_base(reservation_base<VirtualMemorySystem> reservation) : _reservation(std::move(reservation)) {}
+  // Adopt a reservation whose first committed_bytes have already been committed by other means.
+  page_stack_base(reservation_base<VirtualMemorySystem> reservation, std::size_t committed_bytes)
+    : _reservation(std::move(reservation)), _committed_and_frozen(committed_bytes)
+  {
+    assert(committed_bytes % page_size() == 0);
+    assert(committed_bytes <= reserved_bytes());
+  }
+  page_stack_base(page_stack_base&& other) noexcept = default;
+  page_stack_base& operator=(page_stack_base&& other) & noexcept
+  {
+    if(this != &other)
+    {
+      discard_committed();
+      _reservation = std::move(other._reservation);
+      _committed_and_frozen = std::move(other._committed_and_frozen);
+    }
+    return *this;
+  }
+  ~page_stack_base() { discard_committed(); }
 
   auto resize(std::size_t new_bytes) -> std::size_t
   {
     new_bytes = detail::round_up(new_bytes, page_size());
+    assert(!frozen() || new_bytes == committed_bytes());
     if(new_bytes > committed_bytes())
     {
-      VirtualMemorySystem::commit(static_cast<char*>(base()) + committed_bytes(), new_bytes - committed_bytes());
+      vm_system().commit(static_cast<char*>(base()) + committed_bytes(), new_bytes - committed_bytes());
     }
     else if(new_bytes < committed_bytes())
     {
-      VirtualMemorySystem::decommit(static_cast<char*>(base()) + new_bytes, committed_bytes() - new_bytes);
+      vm_system().decommit(static_cast<char*>(base()) + new_bytes, committed_bytes() - new_bytes);
     }
-    _committed_bytes = new_bytes;
+    set_committed_bytes(new_bytes);
     return committed_bytes();
   }
+  auto try_extend(reservation_size_t reserved_bytes) -> bool { return _reservation.try_extend(reserved_bytes); }
+  // Move the committed pages of source starting at offset behind the committed pages of this stack without copying.
+  // offset must be a multiple of the page size and this stack must have enough uncommitted reserved space left.
+  auto append_pages_from(page_stack_base& source, std::size_t offset) -> void
+  {
+    assert(offset % page_size() == 0);
+    assert(offset <= source.committed_bytes());
+    assert(!frozen() && !source.frozen());
+    auto const num_bytes = source.committed_bytes() - offset;
+    assert(reserved_bytes() - committed_bytes() >= num_bytes);
+    if(num_bytes > 0)
+    {
+      auto* const from = static_cast<char*>(source.base()) + offset;
+      vm_system().move_pages(from, static_cast<char*>(base()) + committed_bytes(), num_bytes);
+      discard(source.vm_system(), from, num_bytes, 0);
+      source.set_committed_bytes(offset);
+      set_committed_bytes(committed_bytes() + num_bytes);
+    }
+  }
+
+  auto residency() const -> page_residency { return residency(0, committed_bytes()); }
+  auto residency(std::size_t offset, std::size_t num_bytes) const -> page_residency
+  {
+    assert(offset <= committed_bytes() && num_bytes <= committed_bytes() - offset);
+    return vm_system().residency(static_cast<char const*>(base()) + offset, num_bytes);
+  }
+
+  // Give an access hint for the committed pages overlapping [offset, offset + num_bytes).
+  // Returns false if the hint is not supported.
+  auto advise(std::size_t offset, std::size_t num_bytes, access_hint hint) -> bool
+  {
+    assert(offset <= committed_bytes() && num_bytes <= committed_bytes() - offset);
+    if(num_bytes == 0)
+    {
+      return true;
+    }
+    auto const first = offset / page_size() * page_size();
+    auto const last = std::min(detail::round_up(offset + num_bytes, page_size()), committed_bytes());
+    return vm_system().advise(static_cast<char*>(base()) + first, last - first, hint);
+  }
+
+  // Make the committed pages read-only until thaw(). Identical read-only pages of several processes can additionally
+  // be merged by the kernel if mergeable is true. Returns false if merging was requested but is not supported.
+  auto freeze(bool mergeable = false) -> bool
+  {
+    assert(!frozen());
+    auto merging = false;
+    if(committed_bytes() > 0)
+    {
+      vm_system().set_read_only(base(), committed_bytes(), true);
+      merging = mergeable && vm_system().set_mergeable(base(), committed_bytes(), true);
+    }
+    set_frozen(merging ? frozen_state::mergeable : frozen_state::read_only);
+    return merging || !mergeable;
+  }
+  auto thaw() -> void
+  {
+    assert(frozen());
+    if(committed_bytes() > 0)
+    {
+      if(frozen_as() == frozen_state::mergeable)
+      {
+        vm_system().set_mergeable(base(), committed_bytes(), false);
+      }
+      vm_system().set_read_only(base(), committed_bytes(), false);
+    }
+    set_frozen(frozen_state::no);
+  }
+  auto frozen() const noexcept -> bool { return frozen_as() != frozen_state::no; }
 
   auto base() const noexcept -> void* { return _reservation.base(); }
-  auto committed_bytes() const noexcept -> std::size_t { return _committed_bytes; }
+  auto committed_bytes() const noexcept -> std::size_t { return _committed_and_frozen & ~frozen_mask; }
   auto reserved_bytes() const noexcept -> std::size_t { return _reservation.reserved_bytes(); }
-  auto page_size() const noexcept -> std::size_t { return VirtualMemorySystem::page_size(); }
+  auto alignment() const noexcept -> std::size_t { return _reservation.alignment(); }
+  auto page_size() const noexcept -> std::size_t { return vm_system().page_size(); }
+  // Whether pages committed by resize() read as zero, only if the system says so.
+  auto commits_zeroed_pages() const noexcept -> bool { return commits_zeroed_pages(vm_system(), 0); }
+
+  auto vm_system() noexcept -> VirtualMemorySystem& { return _reservation.vm_system(); }
+  auto vm_system() const noexcept -> VirtualMemorySystem const& { return _reservation.vm_system(); }
 
 private:
+  // Systems that account for committed memory can define discard(offset, num_bytes), which is called for committed
+  // pages right before they are released together with the reservation, and on the system of the source stack after
+  // its pages were moved to another stack.
+  template<typename VMS>
+  static auto discard(VMS& vms, void* offset, std::size_t num_bytes, int) noexcept
+    -> decltype(vms.discard(offset, num_bytes))
+  {
+    vms.discard(offset, num_bytes);
+  }
+  template<typename VMS>
+  static auto discard(VMS&, void*, std::size_t, long) noexcept -> void
+  {}
+  template<typename VMS>
+  static auto commits_zeroed_pages(VMS const& vms, int) noexcept -> decltype(vms.commits_zeroed_pages())
+  {
+    return vms.commits_zeroed_pages();
+  }
+  template<typename VMS>
+  static auto commits_zeroed_pages(VMS const&, long) noexcept -> bool
+  {
+    return false;
+  }
+  auto discard_committed() noexcept -> void
+  {
+    if(committed_bytes() > 0)
+    {
+      discard(vm_system(), base(), committed_bytes(), 0);
+    }
+  }
+
+  enum class frozen_state : std::size_t
+  {
+    no,
+    read_only,
+    mergeable,
+  };
+
+  // The committed bytes are a multiple of the page size, so the frozen state lives in the low bits and takes no space.
+  static constexpr std::size_t frozen_mask = 3;
+
+  auto frozen_as() const noexcept -> frozen_state
+  {
+    return static_cast<frozen_state>(_committed_and_frozen & frozen_mask);
+  }
+  auto set_frozen(frozen_state state) noexcept -> void
+  {
+    _committed_and_frozen = committed_bytes() | static_cast<std::size_t>(state);
+  }
+  auto set_committed_bytes(std::size_t num_bytes) noexcept -> void
+  {
+    assert((num_bytes & frozen_mask) == 0);
+    _committed_and_frozen = num_bytes | (_committed_and_frozen & frozen_mask);
+  }
+
   reservation_base<VirtualMemorySystem> _reservation;
-  detail::value_init_when_moved_from<std::size_t> _committed_bytes = 0;
+  detail::value_init_when_moved_from<std::size_t> _committed_and_frozen = 0;
 };
 
+template<typename VirtualMemorySystem>
+constexpr std::size_t mknejp::vmcontainer::vm::page_stack_base<VirtualMemorySystem>::frozen_mask;
+
 class mknejp::vmcontainer::vm::page_stack final : public page_stack_base<system_default>
 {
   using page_stack_base<system_default>::page_stack_base;
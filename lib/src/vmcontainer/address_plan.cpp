@@ -0,0 +1,76 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "vmcontainer/address_plan.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+
+auto mknejp::vmcontainer::vm::address_plan::instance() -> address_plan&
+{
+  static address_plan plan;
+  return plan;
+}
+
+auto mknejp::vmcontainer::vm::address_plan::assign(std::string name, void* base, std::size_t num_bytes) -> void
+{
+  auto const first = reinterpret_cast<std::uintptr_t>(base);
+  auto const page_size = system_default::page_size();
+  if(base == nullptr || num_bytes == 0 || first % page_size != 0)
+  {
+    throw std::invalid_argument("address range must be non-empty and page aligned");
+  }
+  auto const last = first + detail::round_up(num_bytes, page_size);
+  if(last < first)
+  {
+    throw std::invalid_argument("address range wraps around");
+  }
+
+  std::lock_guard<std::mutex> const lock(_mutex);
+  for(auto const& entry : _ranges)
+  {
+    auto const other_first = reinterpret_cast<std::uintptr_t>(entry.second.base);
+    auto const other_last = other_first + entry.second.num_bytes;
+    if(first < other_last && other_first < last)
+    {
+      throw std::invalid_argument("address range overlaps \"" + entry.first + "\"");
+    }
+  }
+  if(!_ranges.emplace(std::move(name), address_range{base, last - first}).second)
+  {
+    throw std::invalid_argument("address range name is already assigned");
+  }
+}
+
+auto mknejp::vmcontainer::vm::address_plan::remove(std::string const& name) -> void
+{
+  std::lock_guard<std::mutex> const lock(_mutex);
+  _ranges.erase(name);
+}
+
+auto mknejp::vmcontainer::vm::address_plan::clear() -> void
+{
+  std::lock_guard<std::mutex> const lock(_mutex);
+  _ranges.clear();
+}
+
+auto mknejp::vmcontainer::vm::address_plan::find(std::string const& name) const -> address_range
+{
+  std::lock_guard<std::mutex> const lock(_mutex);
+  auto const it = _ranges.find(name);
+  return it == _ranges.end() ? address_range{} : it->second;
+}
+
+auto mknejp::vmcontainer::vm::address_plan::reserve(std::string const& name) const -> reservation
+{
+  auto const range = find(name);
+  if(range.base == nullptr)
+  {
+    throw std::out_of_range("no address range assigned to \"" + name + "\"");
+  }
+  return reservation(range.base, num_bytes(range.num_bytes));
+}
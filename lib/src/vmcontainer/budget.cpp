@@ -0,0 +1,124 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "vmcontainer/budget.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+constexpr std::size_t mknejp::vmcontainer::vm::memory_budget::unlimited;
+
+mknejp::vmcontainer::vm::memory_budget::memory_budget(std::size_t hard_limit, memory_budget* parent)
+  : _hard_limit(hard_limit), _parent(parent)
+{}
+
+auto mknejp::vmcontainer::vm::memory_budget::global() -> memory_budget&
+{
+  static memory_budget budget(unlimited, nullptr);
+  return budget;
+}
+
+auto mknejp::vmcontainer::vm::memory_budget::cgroup_limit() -> std::size_t
+{
+#ifdef __linux__
+  auto path = std::string();
+  if(auto* const file = std::fopen("/proc/self/cgroup", "re"))
+  {
+    char line[4096];
+    while(std::fgets(line, sizeof(line), file))
+    {
+      // cgroup v2 has a single hierarchy with ID 0 and no controllers: "0::/path"
+      if(std::strncmp(line, "0::", 3) == 0)
+      {
+        path = line + 3;
+        path.erase(path.find_last_not_of('\n') + 1);
+        break;
+      }
+    }
+    std::fclose(file);
+  }
+  if(path.empty())
+  {
+    return unlimited;
+  }
+  auto result = unlimited;
+  if(auto* const file = std::fopen(("/sys/fs/cgroup" + path + "/memory.max").c_str(), "re"))
+  {
+    unsigned long long limit = 0;
+    if(std::fscanf(file, "%llu", &limit) == 1)
+    {
+      result = static_cast<std::size_t>(limit);
+    }
+    std::fclose(file);
+  }
+  return result;
+#else
+  return unlimited;
+#endif
+}
+
+auto mknejp::vmcontainer::vm::memory_budget::set_soft_limit(std::size_t num_bytes, callback_type callback) -> void
+{
+  _soft_limit = num_bytes;
+  _soft_limit_callback = std::move(callback);
+}
+
+auto mknejp::vmcontainer::vm::memory_budget::try_charge(std::size_t num_bytes) -> bool
+{
+  auto previous_bytes = std::size_t(0);
+  if(!try_charge_self(num_bytes, previous_bytes))
+  {
+    return false;
+  }
+  if(_parent && !_parent->try_charge(num_bytes))
+  {
+    uncharge_self(num_bytes);
+    return false;
+  }
+  // The watermark is crossed by the charge that takes the committed bytes from below to at or above it.
+  if(_soft_limit_callback && previous_bytes < _soft_limit && num_bytes >= _soft_limit - previous_bytes)
+  {
+    _soft_limit_callback(*this, previous_bytes + num_bytes);
+  }
+  return true;
+}
+
+auto mknejp::vmcontainer::vm::memory_budget::uncharge(std::size_t num_bytes) noexcept -> void
+{
+  for(auto* budget = this; budget != nullptr; budget = budget->_parent)
+  {
+    budget->uncharge_self(num_bytes);
+  }
+}
+
+auto mknejp::vmcontainer::vm::memory_budget::try_charge_self(std::size_t num_bytes,
+                                                             std::size_t& previous_bytes) noexcept -> bool
+{
+  auto const hard_limit = this->hard_limit();
+  auto current = _committed_bytes.load(std::memory_order_relaxed);
+  do
+  {
+    if(num_bytes > hard_limit || current > hard_limit - num_bytes)
+    {
+      return false;
+    }
+  } while(!_committed_bytes.compare_exchange_weak(current, current + num_bytes, std::memory_order_relaxed));
+  previous_bytes = current;
+  return true;
+}
+
+auto mknejp::vmcontainer::vm::memory_budget::uncharge_self(std::size_t num_bytes) noexcept -> void
+{
+  // Saturate, pages adopted from outside the budget may be uncharged without having been charged.
+  auto current = _committed_bytes.load(std::memory_order_relaxed);
+  while(!_committed_bytes.compare_exchange_weak(
+    current, current - std::min(current, num_bytes), std::memory_order_relaxed))
+  {
+  }
+}
@@ -0,0 +1,156 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "vmcontainer/checkpoint.hpp"
+
+#ifndef WIN32
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <system_error>
+
+namespace
+{
+  // The elements start at a fixed offset that is a multiple of all common page sizes so any machine can map them.
+  constexpr std::size_t header_bytes = 64 * 1024;
+
+  struct checkpoint_header
+  {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t header_bytes;
+    std::uint64_t element_size;
+    std::uint64_t element_alignment;
+    std::uint64_t count;
+  };
+
+  constexpr char checkpoint_magic[8] = {'v', 'm', 'c', 'c', 'k', 'p', 't', '\0'};
+  constexpr std::uint32_t checkpoint_version = 1;
+
+#ifndef WIN32
+  [[noreturn]] auto throw_errno(char const* what) -> void
+  {
+    throw std::system_error(std::error_code(errno, std::system_category()), what);
+  }
+
+  [[noreturn]] auto throw_invalid(char const* what) -> void
+  {
+    throw std::system_error(std::make_error_code(std::errc::invalid_argument), what);
+  }
+
+  auto write_all(int fd, char const* p, std::size_t num_bytes) -> void
+  {
+    // Large writes are split up since some systems cap the size of a single write.
+    constexpr std::size_t max_chunk = std::size_t(1) << 30;
+    while(num_bytes > 0)
+    {
+      auto const result = ::write(fd, p, std::min(num_bytes, max_chunk));
+      if(result < 0)
+      {
+        if(errno == EINTR)
+        {
+          continue;
+        }
+        throw_errno("writing checkpoint failed");
+      }
+      p += result;
+      num_bytes -= static_cast<std::size_t>(result);
+    }
+  }
+#endif
+}
+
+auto mknejp::vmcontainer::detail::write_checkpoint(int fd, void const* data, checkpoint_layout layout) -> void
+{
+#ifdef WIN32
+  (void)fd;
+  (void)data;
+  (void)layout;
+  throw std::system_error(std::make_error_code(std::errc::not_supported), "checkpoints are not supported");
+#else
+  auto header = checkpoint_header{};
+  std::memcpy(header.magic, checkpoint_magic, sizeof(checkpoint_magic));
+  header.version = checkpoint_version;
+  header.header_bytes = static_cast<std::uint32_t>(header_bytes);
+  header.element_size = layout.element_size;
+  header.element_alignment = layout.element_alignment;
+  header.count = layout.count;
+
+  // Padding is written instead of seeking so the file can also be a pipe or socket.
+  static char const padding[header_bytes - sizeof(checkpoint_header)] = {};
+  write_all(fd, reinterpret_cast<char const*>(&header), sizeof(header));
+  write_all(fd, padding, sizeof(padding));
+  // The elements start at the page aligned base of the container so every write covers whole pages except the last.
+  write_all(fd, static_cast<char const*>(data), layout.element_size * layout.count);
+#endif
+}
+
+auto mknejp::vmcontainer::detail::map_checkpoint(int fd, checkpoint_layout layout, reservation_size_t reserved_bytes)
+  -> released_storage<vm::page_stack>
+{
+#ifdef WIN32
+  (void)fd;
+  (void)layout;
+  (void)reserved_bytes;
+  throw std::system_error(std::make_error_code(std::errc::not_supported), "checkpoints are not supported");
+#else
+  auto const page_size = vm::system_default::page_size();
+  assert(header_bytes % page_size == 0);
+
+  auto header = checkpoint_header{};
+  auto const result = ::pread(fd, &header, sizeof(header), 0);
+  if(result < 0)
+  {
+    throw_errno("reading checkpoint failed");
+  }
+  if(static_cast<std::size_t>(result) != sizeof(header)
+     || std::memcmp(header.magic, checkpoint_magic, sizeof(checkpoint_magic)) != 0
+     || header.version != checkpoint_version || header.header_bytes != header_bytes)
+  {
+    throw_invalid("not a pinned_vector checkpoint");
+  }
+  if(header.element_size != layout.element_size || header.element_alignment != layout.element_alignment)
+  {
+    throw_invalid("checkpoint element type does not match");
+  }
+
+  // The count comes from the file, a corrupt one must not wrap around in the size computations below.
+  if(header.count > (std::numeric_limits<std::size_t>::max() - header_bytes) / header.element_size)
+  {
+    throw_invalid("checkpoint is corrupt");
+  }
+  auto const used_bytes = static_cast<std::size_t>(header.count) * static_cast<std::size_t>(header.element_size);
+  struct stat info = {};
+  if(::fstat(fd, &info) != 0)
+  {
+    throw_errno("reading checkpoint failed");
+  }
+  if(static_cast<std::size_t>(info.st_size) < header_bytes + used_bytes)
+  {
+    throw_invalid("checkpoint is truncated");
+  }
+
+  // Mapping past the end of the file is fine as long as every page contains at least one byte of the file.
+  auto const committed_bytes = detail::round_up(used_bytes, page_size);
+  auto reservation = vm::reservation(num_bytes(std::max(reserved_bytes.num_bytes(page_size), committed_bytes))
+                                       .aligned_to(reserved_bytes.alignment(page_size)));
+  if(committed_bytes > 0
+     && ::mmap(reservation.base(), committed_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, header_bytes)
+          == MAP_FAILED)
+  {
+    throw_errno("mapping checkpoint failed");
+  }
+  return {vm::page_stack(std::move(reservation), committed_bytes), used_bytes};
+#endif
+}
@@ -0,0 +1,293 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "vmcontainer/dirty_tracking.hpp"
+
+#ifndef WIN32
+#  include <signal.h>
+#  include <sys/mman.h>
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+
+namespace
+{
+  using mknejp::vmcontainer::vm::dirty_page_tracker;
+  using epoch_type = dirty_page_tracker::epoch_type;
+
+  // Set in the stamp of pages the tracker has write-protected.
+  constexpr auto protected_bit = epoch_type(1) << 31;
+
+  // The fault handler cannot take locks, so trackers live in a fixed table of slots.
+  constexpr auto max_trackers = std::size_t(256);
+  std::atomic<dirty_page_tracker*> trackers[max_trackers];
+  std::mutex handler_mutex;
+
+#ifndef WIN32
+  using sigaction_type = struct sigaction;
+  // Published before the handler is installed. Replaced copies are never freed since a handler running on another
+  // thread may still be reading them.
+  std::atomic<sigaction_type const*> previous_action = {nullptr};
+
+  auto on_fault(int sig, siginfo_t* info, void* context) -> void
+  {
+    for(auto& slot : trackers)
+    {
+      auto* const tracker = slot.load(std::memory_order_acquire);
+      if(tracker != nullptr && tracker->handle_write_fault(info->si_addr))
+      {
+        return;
+      }
+    }
+    // Not a write to a tracked page, defer to whoever handled it before.
+    auto const* const previous = previous_action.load(std::memory_order_acquire);
+    if(previous != nullptr && (previous->sa_flags & SA_SIGINFO))
+    {
+      previous->sa_sigaction(sig, info, context);
+    }
+    else if(previous == nullptr || previous->sa_handler == SIG_DFL || previous->sa_handler == SIG_IGN)
+    {
+      // Returning re-executes the faulting instruction which now terminates the process.
+      auto action = sigaction_type();
+      action.sa_handler = SIG_DFL;
+      sigemptyset(&action.sa_mask);
+      ::sigaction(sig, &action, nullptr);
+    }
+    else
+    {
+      previous->sa_handler(sig);
+    }
+  }
+
+  // Others (test frameworks, crash reporters) may have replaced the handler since the last tracker was created.
+  auto install_handler() -> void
+  {
+    auto current = sigaction_type();
+    ::sigaction(SIGSEGV, nullptr, &current);
+    if((current.sa_flags & SA_SIGINFO) && current.sa_sigaction == &on_fault)
+    {
+      return;
+    }
+    previous_action.store(new sigaction_type(current), std::memory_order_release);
+    auto action = sigaction_type();
+    action.sa_sigaction = &on_fault;
+    action.sa_flags = SA_SIGINFO | SA_ONSTACK | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if(::sigaction(SIGSEGV, &action, nullptr) != 0)
+    {
+      throw std::system_error(std::error_code(errno, std::system_category()), "installing the fault handler failed");
+    }
+  }
+#endif
+}
+
+mknejp::vmcontainer::vm::dirty_page_tracker::dirty_page_tracker(void* base,
+                                                                std::size_t reserved_bytes,
+                                                                std::size_t page_size)
+  : _base(static_cast<char*>(base))
+  , _reserved_bytes(reserved_bytes)
+  , _page_size(page_size)
+  , _stamps(num_bytes(std::max(reserved_bytes / page_size, std::size_t(1)) * sizeof(std::atomic<epoch_type>)))
+  , _stamps_base(static_cast<std::atomic<epoch_type>*>(_stamps.base()))
+{
+#ifdef WIN32
+  throw std::system_error(std::make_error_code(std::errc::function_not_supported), "dirty page tracking");
+#else
+  std::lock_guard<std::mutex> const lock(handler_mutex);
+  install_handler();
+  for(_slot = 0; _slot < max_trackers; ++_slot)
+  {
+    auto* expected = static_cast<dirty_page_tracker*>(nullptr);
+    if(trackers[_slot].compare_exchange_strong(expected, this, std::memory_order_release))
+    {
+      return;
+    }
+  }
+  throw std::length_error("too many dirty page trackers");
+#endif
+}
+
+mknejp::vmcontainer::vm::dirty_page_tracker::~dirty_page_tracker()
+{
+  trackers[_slot].store(nullptr, std::memory_order_release);
+}
+
+auto mknejp::vmcontainer::vm::dirty_page_tracker::advance_epoch() -> epoch_type
+{
+  auto const epoch = current_epoch();
+  auto* const s = stamps();
+  auto const num_pages = committed_bytes() / _page_size;
+  // Protect runs of pages written since they were last protected with a single call each.
+  for(auto first = std::size_t(0); first < num_pages;)
+  {
+    if(s[first].load(std::memory_order_relaxed) & protected_bit)
+    {
+      ++first;
+      continue;
+    }
+    auto last = first + 1;
+    while(last < num_pages && !(s[last].load(std::memory_order_relaxed) & protected_bit))
+    {
+      ++last;
+    }
+    protect(first, last);
+    for(; first < last; ++first)
+    {
+      s[first].fetch_or(protected_bit, std::memory_order_relaxed);
+    }
+  }
+  assert(epoch + 1 < protected_bit);
+  _epoch.store(epoch + 1, std::memory_order_relaxed);
+  return epoch + 1;
+}
+
+auto mknejp::vmcontainer::vm::dirty_page_tracker::dirty_pages_since(epoch_type epoch) const
+  -> std::vector<std::size_t>
+{
+  auto result = std::vector<std::size_t>();
+  auto const* const s = stamps();
+  auto const num_pages = committed_bytes() / _page_size;
+  for(auto i = std::size_t(0); i < num_pages; ++i)
+  {
+    if((s[i].load(std::memory_order_relaxed) & ~protected_bit) >= epoch)
+    {
+      result.push_back(i);
+    }
+  }
+  return result;
+}
+
+auto mknejp::vmcontainer::vm::dirty_page_tracker::record_commit(void* offset, std::size_t num_bytes) -> void
+{
+  auto const first = static_cast<std::size_t>(static_cast<char*>(offset) - _base);
+  assert(first % _page_size == 0 && num_bytes % _page_size == 0);
+  assert(first <= _reserved_bytes && num_bytes <= _reserved_bytes - first);
+  auto const last = first + num_bytes;
+  auto const old_stamps = _stamps.committed_bytes() / sizeof(std::atomic<epoch_type>);
+  auto const new_stamps = last / _page_size;
+  if(new_stamps > old_stamps)
+  {
+    _stamps.resize(new_stamps * sizeof(std::atomic<epoch_type>));
+    for(auto i = old_stamps; i < _stamps.committed_bytes() / sizeof(std::atomic<epoch_type>); ++i)
+    {
+      ::new(static_cast<void*>(stamps() + i)) std::atomic<epoch_type>(0);
+    }
+  }
+  auto const epoch = current_epoch();
+  for(auto i = first / _page_size; i < new_stamps; ++i)
+  {
+    stamps()[i].store(epoch, std::memory_order_relaxed);
+  }
+  if(last > committed_bytes())
+  {
+    _committed_bytes.store(last, std::memory_order_release);
+  }
+}
+
+auto mknejp::vmcontainer::vm::dirty_page_tracker::record_decommit(void* offset, std::size_t num_bytes) noexcept
+  -> void
+{
+  // Pages are only ever removed from the end.
+  auto const first = static_cast<std::size_t>(static_cast<char*>(offset) - _base);
+  if(first + num_bytes >= committed_bytes())
+  {
+    _committed_bytes.store(std::min(first, committed_bytes()), std::memory_order_release);
+  }
+}
+
+auto mknejp::vmcontainer::vm::dirty_page_tracker::record_extend(std::size_t num_bytes) -> void
+{
+  assert(num_bytes % _page_size == 0);
+  auto const stamp_bytes = (_reserved_bytes + num_bytes) / _page_size * sizeof(std::atomic<epoch_type>);
+  if(!_stamps.try_extend(vmcontainer::num_bytes(stamp_bytes)))
+  {
+    auto moved = page_stack(vmcontainer::num_bytes(stamp_bytes));
+    moved.resize(_stamps.committed_bytes());
+    auto* const s = static_cast<std::atomic<epoch_type>*>(moved.base());
+    for(auto i = std::size_t(0); i < _stamps.committed_bytes() / sizeof(std::atomic<epoch_type>); ++i)
+    {
+      ::new(static_cast<void*>(s + i)) std::atomic<epoch_type>(stamps()[i].load(std::memory_order_relaxed));
+    }
+    _stamps_base.store(s, std::memory_order_release);
+    // Leaked for the fault handler, like previous_action.
+    new page_stack(std::move(_stamps));
+    _stamps = std::move(moved);
+  }
+  _reserved_bytes += num_bytes;
+}
+
+auto mknejp::vmcontainer::vm::dirty_page_tracker::set_frozen(bool frozen) -> void
+{
+  if(!frozen)
+  {
+    auto const* const s = stamps();
+    auto const num_pages = committed_bytes() / _page_size;
+    for(auto first = std::size_t(0); first < num_pages;)
+    {
+      if(!(s[first].load(std::memory_order_relaxed) & protected_bit))
+      {
+        ++first;
+        continue;
+      }
+      auto last = first + 1;
+      while(last < num_pages && (s[last].load(std::memory_order_relaxed) & protected_bit))
+      {
+        ++last;
+      }
+      protect(first, last);
+      first = last;
+    }
+  }
+  _frozen.store(frozen, std::memory_order_release);
+}
+
+auto mknejp::vmcontainer::vm::dirty_page_tracker::handle_write_fault(void* address) noexcept -> bool
+{
+  auto const* const p = static_cast<char*>(address);
+  // Writes to frozen storage are errors like they are without tracking.
+  if(_frozen.load(std::memory_order_acquire) || p < _base || p >= _base + committed_bytes())
+  {
+    return false;
+  }
+  auto const page = static_cast<std::size_t>(p - _base) / _page_size;
+  auto& stamp = stamps()[page];
+#ifdef WIN32
+  (void)stamp;
+  return false;
+#else
+  // Without the protected bit another thread faulting on the same page usually got here first and made it writable
+  // already. But the stamp is recorded before the mapping exists when pages are moved in, so only retry the write
+  // once the page is known to be writable, otherwise it faults forever.
+  if(::mprotect(_base + page * _page_size, _page_size, PROT_READ | PROT_WRITE) != 0)
+  {
+    return false;
+  }
+  if(stamp.load(std::memory_order_acquire) & protected_bit)
+  {
+    stamp.store(current_epoch(), std::memory_order_release);
+  }
+  return true;
+#endif
+}
+
+auto mknejp::vmcontainer::vm::dirty_page_tracker::protect(std::size_t first_page, std::size_t last_page) -> void
+{
+#ifdef WIN32
+  (void)first_page;
+  (void)last_page;
+#else
+  if(::mprotect(_base + first_page * _page_size, (last_page - first_page) * _page_size, PROT_READ) != 0)
+  {
+    throw std::system_error(std::error_code(errno, std::system_category()), "changing page protection failed");
+  }
+#endif
+}
@@ -0,0 +1,791 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "vmcontainer/file_storage.hpp"
+#include "vmcontainer/realtime.hpp"
+
+#ifdef WIN32
+#  include <io.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/socket.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <system_error>
+
+// Real-time threads must not block in the kernel, see vm::realtime_thread_scope.
+#define VMCONTAINER_ASSERT_NOT_REALTIME() \
+  assert(!is_realtime_thread() && "virtual memory system call on a real-time thread")
+
+namespace
+{
+#ifdef __linux__
+  [[noreturn]] auto throw_errno(char const* what) -> void
+  {
+    throw std::system_error(std::error_code(errno, std::system_category()), what);
+  }
+
+  auto create_memfd() -> mknejp::vmcontainer::vm::file_descriptor
+  {
+    auto const fd = ::memfd_create("vmcontainer", MFD_CLOEXEC);
+    if(fd < 0)
+    {
+      throw_errno("memfd_create failed");
+    }
+    return mknejp::vmcontainer::vm::file_descriptor(fd);
+  }
+
+  auto map_file(void* offset, std::size_t num_bytes, int prot, int flags, int fd, std::size_t file_offset) -> bool
+  {
+    return ::mmap(offset, num_bytes, prot, flags | MAP_FIXED, fd, static_cast<off_t>(file_offset)) != MAP_FAILED;
+  }
+
+  // Put pages back into the reserved but uncommitted state.
+  auto map_reserved(void* offset, std::size_t num_bytes) -> void
+  {
+    auto const result = ::mmap(offset, num_bytes, PROT_NONE, MAP_ANON | MAP_PRIVATE | MAP_FIXED, 0, 0);
+    (void)result;
+    assert(result == offset);
+  }
+
+  auto write_all(int fd, char const* p, std::size_t num_bytes, std::size_t file_offset) -> void
+  {
+    while(num_bytes > 0)
+    {
+      auto const result = ::pwrite(fd, p, num_bytes, static_cast<off_t>(file_offset));
+      if(result < 0)
+      {
+        if(errno == EINTR)
+        {
+          continue;
+        }
+        throw_errno("writing to file failed");
+      }
+      p += result;
+      num_bytes -= static_cast<std::size_t>(result);
+      file_offset += static_cast<std::size_t>(result);
+    }
+  }
+
+  auto truncate(int fd, std::size_t num_bytes) -> void
+  {
+    if(::ftruncate(fd, static_cast<off_t>(num_bytes)) != 0)
+    {
+      throw_errno("resizing file failed");
+    }
+  }
+
+  auto read_all(int fd, char* p, std::size_t num_bytes, std::size_t file_offset) -> void
+  {
+    while(num_bytes > 0)
+    {
+      auto const result = ::pread(fd, p, num_bytes, static_cast<off_t>(file_offset));
+      if(result < 0 && errno == EINTR)
+      {
+        continue;
+      }
+      if(result <= 0)
+      {
+        throw_errno("reading from file failed");
+      }
+      p += result;
+      num_bytes -= static_cast<std::size_t>(result);
+      file_offset += static_cast<std::size_t>(result);
+    }
+  }
+
+  // Grow the file so that writes to the new range are backed by disk blocks and cannot fail with SIGBUS later.
+  auto allocate(int fd, std::size_t file_offset, std::size_t num_bytes) -> bool
+  {
+    if(::fallocate(fd, 0, static_cast<off_t>(file_offset), static_cast<off_t>(num_bytes)) == 0)
+    {
+      return true;
+    }
+    if(errno != EOPNOTSUPP)
+    {
+      return false;
+    }
+    return ::ftruncate(fd, static_cast<off_t>(file_offset + num_bytes)) == 0;
+  }
+
+  auto file_size(int fd) -> std::size_t
+  {
+    struct stat info = {};
+    if(::fstat(fd, &info) != 0)
+    {
+      throw_errno("querying file size failed");
+    }
+    return static_cast<std::size_t>(info.st_size);
+  }
+
+  struct file_header
+  {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t header_bytes;
+    std::uint64_t used_bytes;
+  };
+
+  constexpr char file_magic[8] = {'v', 'm', 'c', 'f', 'i', 'l', 'e', '\0'};
+  constexpr std::uint32_t file_version = 1;
+
+  struct shared_header
+  {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t header_bytes;
+    std::uint64_t reserved_bytes;
+    // Readers may map this many bytes, the file never shrinks below it.
+    std::atomic<std::uint64_t> file_bytes;
+    std::atomic<std::uint64_t> used_bytes;
+  };
+  static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "shared_page_stack requires lock-free 64 bit atomics");
+
+  constexpr char shared_magic[8] = {'v', 'm', 'c', 's', 'h', 'r', 'd', '\0'};
+  constexpr std::uint32_t shared_version = 1;
+
+  // Call f(offset, num_bytes) for each run of pages of a private file mapping that differ from the file. Pages that
+  // are still backed by the file or were never touched since being mapped are skipped, which requires
+  // /proc/self/pagemap. Falls back to treating everything as modified if that is not available.
+  template<typename F>
+  auto for_each_modified_run(char const* base, std::size_t num_bytes, std::size_t page_size, F f) -> void
+  {
+    auto const pagemap = mknejp::vmcontainer::vm::file_descriptor(::open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC));
+    if(!pagemap)
+    {
+      f(std::size_t(0), num_bytes);
+      return;
+    }
+
+    constexpr auto present = std::uint64_t(1) << 63;
+    constexpr auto swapped = std::uint64_t(1) << 62;
+    constexpr auto file_page = std::uint64_t(1) << 61;
+
+    std::uint64_t entries[512];
+    auto const num_pages = num_bytes / page_size;
+    auto const first_page = reinterpret_cast<std::uintptr_t>(base) / page_size;
+    auto run_begin = num_pages;
+    for(std::size_t i = 0; i < num_pages; i += 512)
+    {
+      auto const n = std::min<std::size_t>(512, num_pages - i);
+      auto const entry_bytes = n * sizeof(std::uint64_t);
+      auto const entry_offset = static_cast<off_t>((first_page + i) * sizeof(std::uint64_t));
+      if(::pread(pagemap.get(), entries, entry_bytes, entry_offset) != static_cast<ssize_t>(entry_bytes))
+      {
+        auto const first = std::min(run_begin, i);
+        f(first * page_size, num_bytes - first * page_size);
+        return;
+      }
+      for(std::size_t j = 0; j < n; ++j)
+      {
+        auto const entry = entries[j];
+        auto const modified = (entry & swapped) != 0 || ((entry & present) != 0 && (entry & file_page) == 0);
+        auto const page = i + j;
+        if(modified && run_begin == num_pages)
+        {
+          run_begin = page;
+        }
+        else if(!modified && run_begin != num_pages)
+        {
+          f(run_begin * page_size, (page - run_begin) * page_size);
+          run_begin = num_pages;
+        }
+      }
+    }
+    if(run_begin != num_pages)
+    {
+      f(run_begin * page_size, (num_pages - run_begin) * page_size);
+    }
+  }
+
+  auto write_modified_pages(int fd, char const* base, std::size_t num_bytes, std::size_t page_size) -> void
+  {
+    for_each_modified_run(base, num_bytes, page_size, [&](std::size_t offset, std::size_t count) {
+      write_all(fd, base + offset, count, offset);
+    });
+  }
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// file_descriptor
+//
+
+auto mknejp::vmcontainer::vm::file_descriptor::reset(int fd) noexcept -> void
+{
+  if(_fd >= 0)
+  {
+#ifdef WIN32
+    ::_close(_fd);
+#else
+    ::close(_fd);
+#endif
+  }
+  _fd = fd;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// memfd_page_stack
+//
+
+mknejp::vmcontainer::vm::memfd_page_stack::memfd_page_stack(reservation_size_t reserved_bytes)
+#ifdef __linux__
+  : _reservation(reserved_bytes)
+{
+  if(base() != nullptr)
+  {
+    _file = std::make_shared<file_descriptor const>(create_memfd());
+  }
+}
+#else
+{
+  (void)reserved_bytes;
+  throw std::system_error(std::make_error_code(std::errc::not_supported), "memfd is not supported");
+}
+#endif
+
+auto mknejp::vmcontainer::vm::memfd_page_stack::resize(std::size_t new_bytes) -> std::size_t
+{
+  VMCONTAINER_ASSERT_NOT_REALTIME();
+#ifdef __linux__
+  new_bytes = detail::round_up(new_bytes, page_size());
+  assert(new_bytes <= reserved_bytes());
+  auto* const p = static_cast<char*>(base());
+  if(new_bytes > committed_bytes())
+  {
+    if(_copy_on_write)
+    {
+      system_default::commit(p + committed_bytes(), new_bytes - committed_bytes());
+    }
+    else
+    {
+      if(::ftruncate(fd(), static_cast<off_t>(new_bytes)) != 0)
+      {
+        throw std::bad_alloc();
+      }
+      if(!map_file(p + committed_bytes(),
+                   new_bytes - committed_bytes(),
+                   PROT_READ | PROT_WRITE,
+                   MAP_SHARED,
+                   fd(),
+                   committed_bytes()))
+      {
+        ::ftruncate(fd(), static_cast<off_t>(committed_bytes()));
+        throw std::bad_alloc();
+      }
+    }
+  }
+  else if(new_bytes < committed_bytes())
+  {
+    map_reserved(p + new_bytes, committed_bytes() - new_bytes);
+    if(_copy_on_write)
+    {
+      _file_bytes = std::min<std::size_t>(_file_bytes, new_bytes);
+    }
+    else
+    {
+      // Releases the pages of the file.
+      auto const result = ::ftruncate(fd(), static_cast<off_t>(new_bytes));
+      (void)result;
+      assert(result == 0);
+    }
+  }
+  _committed_bytes = new_bytes;
+#else
+  (void)new_bytes;
+#endif
+  return committed_bytes();
+}
+
+auto mknejp::vmcontainer::vm::memfd_page_stack::snapshot() -> memfd_snapshot
+{
+#ifdef __linux__
+  if(_copy_on_write)
+  {
+    if(_file.use_count() != 1)
+    {
+      return snapshot_modified_pages();
+    }
+    write_back();
+  }
+  auto const n = committed_bytes();
+  if(n == 0)
+  {
+    return {};
+  }
+  auto view = reservation(num_bytes(n));
+  if(!map_file(view.base(), n, PROT_READ, MAP_PRIVATE, fd(), 0))
+  {
+    throw_errno("mapping snapshot failed");
+  }
+  // Writes must not reach the file any more, otherwise they would show up in the snapshot.
+  if(!map_file(base(), n, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd(), 0))
+  {
+    throw_errno("mapping snapshot failed");
+  }
+  _copy_on_write = true;
+  _file_bytes = n;
+  return memfd_snapshot(std::move(view), _file, n);
+#else
+  return {};
+#endif
+}
+
+auto mknejp::vmcontainer::vm::memfd_page_stack::snapshot_modified_pages() -> memfd_snapshot
+{
+#ifdef __linux__
+  auto const* const p = static_cast<char const*>(base());
+  auto const n = committed_bytes();
+  if(n == 0)
+  {
+    return {};
+  }
+  // Share the unmodified pages with the file, only the pages this stack has written or committed since it was mapped
+  // from the file are copied.
+  auto view = reservation(num_bytes(n));
+  auto* const q = static_cast<char*>(view.base());
+  auto const file_bytes = std::min<std::size_t>(_file_bytes, n);
+  if(file_bytes > 0 && !map_file(q, file_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd(), 0))
+  {
+    throw_errno("mapping snapshot failed");
+  }
+  if(n > file_bytes)
+  {
+    system_default::commit(q + file_bytes, n - file_bytes);
+    std::memcpy(q + file_bytes, p + file_bytes, n - file_bytes);
+  }
+  for_each_modified_run(p, file_bytes, page_size(), [&](std::size_t offset, std::size_t count) {
+    std::memcpy(q + offset, p + offset, count);
+  });
+  system_default::set_read_only(q, n, true);
+  return memfd_snapshot(std::move(view), _file, n);
+#else
+  return {};
+#endif
+}
+
+auto mknejp::vmcontainer::vm::memfd_page_stack::write_back() -> void
+{
+#ifdef __linux__
+  assert(_file.use_count() == 1);
+  auto const* const p = static_cast<char const*>(base());
+  auto const n = committed_bytes();
+  // No snapshot refers to the file any more so it can be updated in place. Everything above _file_bytes has been
+  // replaced by anonymous memory, truncating first makes the file read zeros there like untouched anonymous pages.
+  truncate(fd(), _file_bytes);
+  truncate(fd(), n);
+  write_modified_pages(fd(), p, n, page_size());
+  if(n > 0 && !map_file(base(), n, PROT_READ | PROT_WRITE, MAP_SHARED, fd(), 0))
+  {
+    throw_errno("mapping file failed");
+  }
+  _copy_on_write = false;
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// file_page_stack
+//
+
+constexpr std::size_t mknejp::vmcontainer::vm::file_page_stack::header_bytes;
+
+mknejp::vmcontainer::vm::file_page_stack::file_page_stack(file_descriptor file, reservation_size_t reserved_bytes)
+  : file_page_stack(std::move(file), nullptr, reserved_bytes)
+{}
+
+mknejp::vmcontainer::vm::file_page_stack::file_page_stack(file_descriptor file,
+                                                          void* address,
+                                                          reservation_size_t reserved_bytes)
+{
+#ifdef __linux__
+  assert(header_bytes % page_size() == 0);
+  auto header = file_header{};
+  auto size = file_size(file.get());
+  if(size == 0)
+  {
+    std::memcpy(header.magic, file_magic, sizeof(file_magic));
+    header.version = file_version;
+    header.header_bytes = header_bytes;
+    write_all(file.get(), reinterpret_cast<char const*>(&header), sizeof(header), 0);
+    truncate(file.get(), header_bytes);
+    size = header_bytes;
+  }
+  else
+  {
+    if(size >= sizeof(header))
+    {
+      read_all(file.get(), reinterpret_cast<char*>(&header), sizeof(header), 0);
+    }
+    if(size < header_bytes || std::memcmp(header.magic, file_magic, sizeof(file_magic)) != 0
+       || header.version != file_version || header.header_bytes != header_bytes)
+    {
+      throw std::system_error(std::make_error_code(std::errc::invalid_argument), "not a pinned storage file");
+    }
+  }
+
+  auto const data_bytes = detail::round_up(size - header_bytes, page_size());
+  if(data_bytes != size - header_bytes)
+  {
+    truncate(file.get(), header_bytes + data_bytes);
+  }
+  auto const total_bytes = num_bytes(std::max(reserved_bytes.num_bytes(page_size()), data_bytes))
+                             .aligned_to(reserved_bytes.alignment(page_size()));
+  _reservation = address ? reservation(address, total_bytes) : reservation(total_bytes);
+  if(data_bytes > 0 && !map_file(base(), data_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, file.get(), header_bytes))
+  {
+    throw_errno("mapping file failed");
+  }
+  _file = std::move(file);
+  _committed_bytes = data_bytes;
+  _used_bytes = std::min<std::size_t>(header.used_bytes, data_bytes);
+#else
+  (void)file;
+  (void)address;
+  (void)reserved_bytes;
+  throw std::system_error(std::make_error_code(std::errc::not_supported), "file backed storage is not supported");
+#endif
+}
+
+mknejp::vmcontainer::vm::file_page_stack::file_page_stack(char const* path, reservation_size_t reserved_bytes)
+  : file_page_stack(path, nullptr, reserved_bytes)
+{}
+
+mknejp::vmcontainer::vm::file_page_stack::file_page_stack(char const* path,
+                                                          void* address,
+                                                          reservation_size_t reserved_bytes)
+#ifdef __linux__
+  : file_page_stack(
+    [path] {
+      auto file = file_descriptor(::open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644));
+      if(!file)
+      {
+        throw_errno("opening file failed");
+      }
+      return file;
+    }(),
+    address,
+    reserved_bytes)
+{}
+#else
+{
+  (void)path;
+  (void)address;
+  (void)reserved_bytes;
+  throw std::system_error(std::make_error_code(std::errc::not_supported), "file backed storage is not supported");
+}
+#endif
+
+auto mknejp::vmcontainer::vm::file_page_stack::resize(std::size_t new_bytes) -> std::size_t
+{
+  VMCONTAINER_ASSERT_NOT_REALTIME();
+#ifdef __linux__
+  new_bytes = detail::round_up(new_bytes, page_size());
+  assert(new_bytes <= reserved_bytes());
+  auto* const p = static_cast<char*>(base());
+  if(new_bytes > committed_bytes())
+  {
+    auto const delta = new_bytes - committed_bytes();
+    auto const file_offset = header_bytes + committed_bytes();
+    if(!allocate(fd(), file_offset, delta))
+    {
+      throw std::bad_alloc();
+    }
+    if(!map_file(p + committed_bytes(), delta, PROT_READ | PROT_WRITE, MAP_SHARED, fd(), file_offset))
+    {
+      ::ftruncate(fd(), static_cast<off_t>(file_offset));
+      throw std::bad_alloc();
+    }
+  }
+  else if(new_bytes < committed_bytes())
+  {
+    map_reserved(p + new_bytes, committed_bytes() - new_bytes);
+    auto const result = ::ftruncate(fd(), static_cast<off_t>(header_bytes + new_bytes));
+    (void)result;
+    assert(result == 0);
+    _used_bytes = std::min<std::size_t>(_used_bytes, new_bytes);
+  }
+  _committed_bytes = new_bytes;
+#else
+  (void)new_bytes;
+#endif
+  return committed_bytes();
+}
+
+auto mknejp::vmcontainer::vm::file_page_stack::flush(std::size_t used_bytes) -> void
+{
+#ifdef __linux__
+  assert(used_bytes <= committed_bytes());
+  flush(0, used_bytes);
+  auto const value = static_cast<std::uint64_t>(used_bytes);
+  write_all(fd(), reinterpret_cast<char const*>(&value), sizeof(value), offsetof(file_header, used_bytes));
+  if(::fdatasync(fd()) != 0)
+  {
+    throw_errno("flushing file failed");
+  }
+  _used_bytes = used_bytes;
+#else
+  (void)used_bytes;
+#endif
+}
+
+auto mknejp::vmcontainer::vm::file_page_stack::flush(std::size_t offset, std::size_t num_bytes) -> void
+{
+#ifdef __linux__
+  assert(offset <= committed_bytes() && committed_bytes() - offset >= num_bytes);
+  auto const first = offset / page_size() * page_size();
+  auto const last = detail::round_up(offset + num_bytes, page_size());
+  if(last > first && ::msync(static_cast<char*>(base()) + first, last - first, MS_SYNC) != 0)
+  {
+    throw_errno("flushing file failed");
+  }
+#else
+  (void)offset;
+  (void)num_bytes;
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// shared_page_stack
+//
+
+mknejp::vmcontainer::vm::shared_page_stack::shared_page_stack(reservation_size_t reserved_bytes)
+{
+#ifdef __linux__
+  auto const data_bytes = detail::round_up(reserved_bytes.num_bytes(page_size()), page_size());
+  if(data_bytes == 0)
+  {
+    return;
+  }
+  auto pages = reservation(num_bytes(page_size() + data_bytes));
+  auto file = create_memfd();
+  truncate(file.get(), page_size());
+  if(!map_file(pages.base(), page_size(), PROT_READ | PROT_WRITE, MAP_SHARED, file.get(), 0))
+  {
+    throw_errno("mapping file failed");
+  }
+  auto* const header = ::new(pages.base()) shared_header{};
+  std::memcpy(header->magic, shared_magic, sizeof(shared_magic));
+  header->version = shared_version;
+  header->header_bytes = static_cast<std::uint32_t>(page_size());
+  header->reserved_bytes = data_bytes;
+  _reservation = std::move(pages);
+  _file = std::move(file);
+#else
+  (void)reserved_bytes;
+  throw std::system_error(std::make_error_code(std::errc::not_supported), "memfd is not supported");
+#endif
+}
+
+auto mknejp::vmcontainer::vm::shared_page_stack::base() const noexcept -> void*
+{
+  return _reservation.base() ? static_cast<char*>(_reservation.base()) + page_size() : nullptr;
+}
+
+auto mknejp::vmcontainer::vm::shared_page_stack::reserved_bytes() const noexcept -> std::size_t
+{
+  return _reservation.base() ? _reservation.reserved_bytes() - page_size() : 0;
+}
+
+auto mknejp::vmcontainer::vm::shared_page_stack::resize(std::size_t new_bytes) -> std::size_t
+{
+  VMCONTAINER_ASSERT_NOT_REALTIME();
+#ifdef __linux__
+  new_bytes = detail::round_up(new_bytes, page_size());
+  assert(new_bytes <= reserved_bytes());
+  auto* const p = static_cast<char*>(base());
+  auto* const header = static_cast<shared_header*>(_reservation.base());
+  if(new_bytes > committed_bytes())
+  {
+    if(new_bytes > _file_bytes)
+    {
+      if(::ftruncate(fd(), static_cast<off_t>(page_size() + new_bytes)) != 0)
+      {
+        throw std::bad_alloc();
+      }
+      _file_bytes = new_bytes;
+      header->file_bytes.store(new_bytes, std::memory_order_release);
+    }
+    auto const prot = PROT_READ | PROT_WRITE;
+    auto const file_offset = page_size() + committed_bytes();
+    if(!map_file(p + committed_bytes(), new_bytes - committed_bytes(), prot, MAP_SHARED, fd(), file_offset))
+    {
+      throw std::bad_alloc();
+    }
+  }
+  else if(new_bytes < committed_bytes())
+  {
+    // Readers may still have the pages mapped, so release them without shrinking the file. The pages are mapped
+    // again from the file when growing, so they must read as zero even if the file system cannot punch holes.
+    if(::fallocate(fd(),
+                   FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                   static_cast<off_t>(page_size() + new_bytes),
+                   static_cast<off_t>(committed_bytes() - new_bytes))
+       != 0)
+    {
+      std::memset(p + new_bytes, 0, committed_bytes() - new_bytes);
+    }
+    map_reserved(p + new_bytes, committed_bytes() - new_bytes);
+  }
+  _committed_bytes = new_bytes;
+#else
+  (void)new_bytes;
+#endif
+  return committed_bytes();
+}
+
+auto mknejp::vmcontainer::vm::shared_page_stack::flush(std::size_t used_bytes) -> void
+{
+  assert(used_bytes <= committed_bytes());
+  if(_reservation.base() != nullptr)
+  {
+    static_cast<shared_header*>(_reservation.base())->used_bytes.store(used_bytes, std::memory_order_release);
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// shared_page_view
+//
+
+mknejp::vmcontainer::vm::shared_page_view::shared_page_view(file_descriptor file)
+{
+#ifdef __linux__
+  char buffer[sizeof(shared_header)];
+  read_all(file.get(), buffer, sizeof(buffer), 0);
+  auto const* const header = reinterpret_cast<shared_header const*>(buffer);
+  if(std::memcmp(header->magic, shared_magic, sizeof(shared_magic)) != 0 || header->version != shared_version
+     || header->header_bytes != page_size())
+  {
+    throw std::system_error(std::make_error_code(std::errc::invalid_argument), "not a shared_page_stack");
+  }
+  auto pages = reservation(num_bytes(page_size() + static_cast<std::size_t>(header->reserved_bytes)));
+  if(!map_file(pages.base(), page_size(), PROT_READ, MAP_SHARED, file.get(), 0))
+  {
+    throw_errno("mapping file failed");
+  }
+  _reservation = std::move(pages);
+  _file = std::move(file);
+  update();
+#else
+  (void)file;
+  throw std::system_error(std::make_error_code(std::errc::not_supported), "memfd is not supported");
+#endif
+}
+
+auto mknejp::vmcontainer::vm::shared_page_view::base() const noexcept -> void const*
+{
+  return _reservation.base() ? static_cast<char const*>(_reservation.base()) + page_size() : nullptr;
+}
+
+auto mknejp::vmcontainer::vm::shared_page_view::reserved_bytes() const noexcept -> std::size_t
+{
+  return _reservation.base() ? _reservation.reserved_bytes() - page_size() : 0;
+}
+
+auto mknejp::vmcontainer::vm::shared_page_view::update() -> std::size_t
+{
+  VMCONTAINER_ASSERT_NOT_REALTIME();
+#ifdef __linux__
+  if(_reservation.base() == nullptr)
+  {
+    return 0;
+  }
+  auto const* const header = static_cast<shared_header const*>(_reservation.base());
+  // Publishing used_bytes happens after growing the file, so file_bytes is at least as large.
+  auto const used_bytes = static_cast<std::size_t>(header->used_bytes.load(std::memory_order_acquire));
+  auto const file_bytes = static_cast<std::size_t>(header->file_bytes.load(std::memory_order_acquire));
+  if(file_bytes > mapped_bytes())
+  {
+    auto* const p = static_cast<char*>(_reservation.base()) + page_size();
+    auto const file_offset = page_size() + mapped_bytes();
+    if(!map_file(p + mapped_bytes(), file_bytes - mapped_bytes(), PROT_READ, MAP_SHARED, _file.get(), file_offset))
+    {
+      throw_errno("mapping file failed");
+    }
+    _mapped_bytes = file_bytes;
+  }
+  return used_bytes;
+#else
+  return 0;
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// fd passing
+//
+
+auto mknejp::vmcontainer::vm::send_fd(int socket, int fd) -> void
+{
+#ifdef __linux__
+  char byte = 0;
+  auto data = ::iovec{&byte, 1};
+  alignas(::cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+  auto message = ::msghdr{};
+  message.msg_iov = &data;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+  auto* const cmsg = CMSG_FIRSTHDR(&message);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+  std::memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+  while(::sendmsg(socket, &message, MSG_NOSIGNAL) < 0)
+  {
+    if(errno != EINTR)
+    {
+      throw_errno("sending file descriptor failed");
+    }
+  }
+#else
+  (void)socket;
+  (void)fd;
+  throw std::system_error(std::make_error_code(std::errc::not_supported), "fd passing is not supported");
+#endif
+}
+
+auto mknejp::vmcontainer::vm::receive_fd(int socket) -> file_descriptor
+{
+#ifdef __linux__
+  char byte = 0;
+  auto data = ::iovec{&byte, 1};
+  alignas(::cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+  auto message = ::msghdr{};
+  message.msg_iov = &data;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+  auto result = ::ssize_t(0);
+  while((result = ::recvmsg(socket, &message, MSG_CMSG_CLOEXEC)) < 0)
+  {
+    if(errno != EINTR)
+    {
+      throw_errno("receiving file descriptor failed");
+    }
+  }
+  auto const* const cmsg = CMSG_FIRSTHDR(&message);
+  if(result == 0 || cmsg == nullptr || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+  {
+    throw std::system_error(std::make_error_code(std::errc::bad_message), "no file descriptor received");
+  }
+  auto fd = -1;
+  std::memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+  return file_descriptor(fd);
+#else
+  (void)socket;
+  throw std::system_error(std::make_error_code(std::errc::not_supported), "fd passing is not supported");
+#endif
+}
@@ -0,0 +1,96 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "vmcontainer/instrumented.hpp"
+
+#include <algorithm>
+
+constexpr std::size_t mknejp::vmcontainer::vm::operation_stats::latency_buckets;
+
+namespace
+{
+  auto latency_bucket(std::chrono::nanoseconds duration) noexcept -> std::size_t
+  {
+    auto bucket = std::size_t(0);
+    for(auto n = static_cast<std::uint64_t>(duration.count()); n > 1; n >>= 1)
+    {
+      ++bucket;
+    }
+    return std::min(bucket, mknejp::vmcontainer::vm::operation_stats::latency_buckets - 1);
+  }
+}
+
+mknejp::vmcontainer::vm::vm_stats::vm_stats() noexcept
+{
+  reset();
+  _hook.store(nullptr, std::memory_order_relaxed);
+}
+
+auto mknejp::vmcontainer::vm::vm_stats::global() noexcept -> vm_stats&
+{
+  static vm_stats stats;
+  return stats;
+}
+
+auto mknejp::vmcontainer::vm::vm_stats::record(operation op,
+                                               void* offset,
+                                               std::size_t num_bytes,
+                                               std::chrono::nanoseconds duration) noexcept -> void
+{
+  auto& c = _counters[static_cast<std::size_t>(op)];
+  c.calls.fetch_add(1, std::memory_order_relaxed);
+  c.bytes.fetch_add(num_bytes, std::memory_order_relaxed);
+  c.nanoseconds.fetch_add(static_cast<std::uint64_t>(duration.count()), std::memory_order_relaxed);
+  c.latency_histogram[latency_bucket(duration)].fetch_add(1, std::memory_order_relaxed);
+  if(op == operation::reserve)
+  {
+    _live_reservations.fetch_add(1, std::memory_order_relaxed);
+  }
+  else if(op == operation::free)
+  {
+    _live_reservations.fetch_sub(1, std::memory_order_relaxed);
+  }
+  if(auto const hook = _hook.load(std::memory_order_acquire))
+  {
+    hook(op, offset, num_bytes, duration);
+  }
+}
+
+auto mknejp::vmcontainer::vm::vm_stats::record_failure(operation op) noexcept -> void
+{
+  _counters[static_cast<std::size_t>(op)].failures.fetch_add(1, std::memory_order_relaxed);
+}
+
+auto mknejp::vmcontainer::vm::vm_stats::get(operation op) const noexcept -> operation_stats
+{
+  auto const& c = _counters[static_cast<std::size_t>(op)];
+  auto result = operation_stats();
+  result.calls = c.calls.load(std::memory_order_relaxed);
+  result.failures = c.failures.load(std::memory_order_relaxed);
+  result.bytes = c.bytes.load(std::memory_order_relaxed);
+  result.total_time = std::chrono::nanoseconds(c.nanoseconds.load(std::memory_order_relaxed));
+  for(std::size_t i = 0; i < result.latency_histogram.size(); ++i)
+  {
+    result.latency_histogram[i] = c.latency_histogram[i].load(std::memory_order_relaxed);
+  }
+  return result;
+}
+
+auto mknejp::vmcontainer::vm::vm_stats::reset() noexcept -> void
+{
+  for(auto& c : _counters)
+  {
+    c.calls.store(0, std::memory_order_relaxed);
+    c.failures.store(0, std::memory_order_relaxed);
+    c.bytes.store(0, std::memory_order_relaxed);
+    c.nanoseconds.store(0, std::memory_order_relaxed);
+    for(auto& bucket : c.latency_histogram)
+    {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+  }
+  _live_reservations.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,126 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "vmcontainer/memory_tag.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+
+namespace
+{
+  struct tag_table
+  {
+    std::mutex mutex;
+    std::map<std::string, std::unique_ptr<mknejp::vmcontainer::vm::memory_tag>> tags;
+  };
+
+  auto table() -> tag_table&
+  {
+    static tag_table instance;
+    return instance;
+  }
+
+  auto subtract_saturated(std::atomic<std::size_t>& value, std::size_t num_bytes) noexcept -> void
+  {
+    auto current = value.load(std::memory_order_relaxed);
+    while(!value.compare_exchange_weak(current, current - std::min(current, num_bytes), std::memory_order_relaxed))
+    {
+    }
+  }
+}
+
+auto mknejp::vmcontainer::vm::memory_tag::get(std::string const& name) -> memory_tag&
+{
+  auto& t = table();
+  std::lock_guard<std::mutex> const lock(t.mutex);
+  auto& tag = t.tags[name];
+  if(!tag)
+  {
+    tag.reset(new memory_tag(name));
+  }
+  return *tag;
+}
+
+auto mknejp::vmcontainer::vm::memory_tag::untagged() -> memory_tag&
+{
+  static auto& tag = get("untagged");
+  return tag;
+}
+
+auto mknejp::vmcontainer::vm::memory_tag::all() -> std::vector<memory_tag_stats>
+{
+  auto result = std::vector<memory_tag_stats>();
+  {
+    auto& t = table();
+    std::lock_guard<std::mutex> const lock(t.mutex);
+    result.reserve(t.tags.size());
+    for(auto const& entry : t.tags)
+    {
+      result.push_back(entry.second->stats());
+    }
+  }
+  std::stable_sort(result.begin(), result.end(), [](memory_tag_stats const& a, memory_tag_stats const& b) {
+    return a.committed_bytes > b.committed_bytes;
+  });
+  return result;
+}
+
+auto mknejp::vmcontainer::vm::memory_tag::dump(std::ostream& out) -> void
+{
+  auto const stats = all();
+  auto name_width = std::size_t(4);
+  for(auto const& s : stats)
+  {
+    name_width = std::max(name_width, s.name.size());
+  }
+  auto const w = static_cast<int>(name_width);
+  out << std::left << std::setw(w) << "tag" << std::right << std::setw(16) << "reserved" << std::setw(16)
+      << "committed" << std::setw(16) << "peak committed" << '\n';
+  for(auto const& s : stats)
+  {
+    out << std::left << std::setw(w) << s.name << std::right << std::setw(16) << s.reserved_bytes << std::setw(16)
+        << s.committed_bytes << std::setw(16) << s.peak_committed_bytes << '\n';
+  }
+}
+
+auto mknejp::vmcontainer::vm::memory_tag::stats() const -> memory_tag_stats
+{
+  auto result = memory_tag_stats();
+  result.name = _name;
+  result.reserved_bytes = _reserved_bytes.load(std::memory_order_relaxed);
+  result.committed_bytes = _committed_bytes.load(std::memory_order_relaxed);
+  result.peak_committed_bytes = _peak_committed_bytes.load(std::memory_order_relaxed);
+  return result;
+}
+
+auto mknejp::vmcontainer::vm::memory_tag::record_reserve(std::size_t num_bytes) noexcept -> void
+{
+  _reserved_bytes.fetch_add(num_bytes, std::memory_order_relaxed);
+}
+
+auto mknejp::vmcontainer::vm::memory_tag::record_free(std::size_t num_bytes) noexcept -> void
+{
+  subtract_saturated(_reserved_bytes, num_bytes);
+}
+
+auto mknejp::vmcontainer::vm::memory_tag::record_commit(std::size_t num_bytes) noexcept -> void
+{
+  auto const committed = _committed_bytes.fetch_add(num_bytes, std::memory_order_relaxed) + num_bytes;
+  auto peak = _peak_committed_bytes.load(std::memory_order_relaxed);
+  while(peak < committed && !_peak_committed_bytes.compare_exchange_weak(peak, committed, std::memory_order_relaxed))
+  {
+  }
+}
+
+auto mknejp::vmcontainer::vm::memory_tag::record_decommit(std::size_t num_bytes) noexcept -> void
+{
+  // Pages adopted from elsewhere may be removed without having been recorded.
+  subtract_saturated(_committed_bytes, num_bytes);
+}
@@ -0,0 +1,109 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "vmcontainer/realtime.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <new>
+
+namespace
+{
+  thread_local unsigned realtime_depth = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// realtime_thread_scope
+//
+
+mknejp::vmcontainer::vm::realtime_thread_scope::realtime_thread_scope() noexcept
+{
+  ++realtime_depth;
+}
+
+mknejp::vmcontainer::vm::realtime_thread_scope::~realtime_thread_scope()
+{
+  assert(realtime_depth > 0);
+  --realtime_depth;
+}
+
+auto mknejp::vmcontainer::vm::is_realtime_thread() noexcept -> bool
+{
+  return realtime_depth > 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// realtime_page_stack
+//
+
+mknejp::vmcontainer::vm::realtime_page_stack::realtime_page_stack(reservation_size_t reserved_bytes)
+  : _reservation(reserved_bytes)
+{
+  lock(_reservation.reserved_bytes());
+}
+
+auto mknejp::vmcontainer::vm::realtime_page_stack::resize(std::size_t new_bytes) -> std::size_t
+{
+  new_bytes = detail::round_up(new_bytes, page_size());
+  if(new_bytes > locked_bytes())
+  {
+    throw std::bad_alloc();
+  }
+  _committed_bytes = new_bytes;
+  return committed_bytes();
+}
+
+auto mknejp::vmcontainer::vm::realtime_page_stack::try_extend(reservation_size_t reserved_bytes) -> bool
+{
+  if(!_reservation.try_extend(reserved_bytes))
+  {
+    return false;
+  }
+  lock(_reservation.reserved_bytes());
+  return true;
+}
+
+auto mknejp::vmcontainer::vm::realtime_page_stack::append_pages_from(realtime_page_stack& source, std::size_t offset)
+  -> void
+{
+  assert(offset % page_size() == 0);
+  assert(offset <= source.committed_bytes());
+  auto const num_bytes = source.committed_bytes() - offset;
+  assert(locked_bytes() - committed_bytes() >= num_bytes);
+  if(num_bytes > 0)
+  {
+    std::memcpy(static_cast<char*>(base()) + committed_bytes(), static_cast<char*>(source.base()) + offset, num_bytes);
+    source._committed_bytes = offset;
+    _committed_bytes += num_bytes;
+  }
+}
+
+auto mknejp::vmcontainer::vm::realtime_page_stack::residency(std::size_t offset, std::size_t num_bytes) const
+  -> page_residency
+{
+  assert(offset <= committed_bytes() && num_bytes <= committed_bytes() - offset);
+  return system_default::residency(static_cast<char const*>(base()) + offset, num_bytes);
+}
+
+// Commit and lock the pages between locked_bytes() and num_bytes.
+auto mknejp::vmcontainer::vm::realtime_page_stack::lock(std::size_t num_bytes) -> void
+{
+  if(num_bytes > locked_bytes())
+  {
+    auto* const first = static_cast<char*>(base()) + locked_bytes();
+    system_default::commit(first, num_bytes - locked_bytes());
+    try
+    {
+      system_default::lock(first, num_bytes - locked_bytes());
+    }
+    catch(...)
+    {
+      system_default::decommit(first, num_bytes - locked_bytes());
+      throw;
+    }
+    _locked_bytes = num_bytes;
+  }
+}
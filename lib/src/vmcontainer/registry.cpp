@@ -0,0 +1,74 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "vmcontainer/registry.hpp"
+
+constexpr std::size_t mknejp::vmcontainer::vm::page_stack_registry::no_trim_request;
+
+auto mknejp::vmcontainer::vm::page_stack_registry::instance() -> page_stack_registry&
+{
+  static page_stack_registry registry;
+  return registry;
+}
+
+auto mknejp::vmcontainer::vm::page_stack_registry::trim_all(trim_policy policy) -> std::size_t
+{
+  auto released_bytes = std::size_t(0);
+  std::lock_guard<std::mutex> const lock(_mutex);
+  for(auto* e = _first; e != nullptr; e = e->next)
+  {
+    auto const committed = e->committed_bytes.load(std::memory_order_relaxed);
+    auto const used = std::min(e->used_bytes.load(std::memory_order_relaxed), committed);
+    auto const slack = committed - used;
+    auto const retained = std::min(slack, policy.retained_slack_bytes);
+    // Committed sizes are whole pages so this is what resize(used + retained) leaves behind.
+    auto const kept = std::min(detail::round_up(used + retained, e->page_size), committed);
+    if(committed - kept > 0 && committed - kept >= policy.min_trimmed_bytes)
+    {
+      e->trim_request.store(retained, std::memory_order_relaxed);
+      released_bytes += committed - kept;
+    }
+  }
+  return released_bytes;
+}
+
+auto mknejp::vmcontainer::vm::page_stack_registry::stats() const -> registry_stats
+{
+  auto result = registry_stats();
+  std::lock_guard<std::mutex> const lock(_mutex);
+  for(auto const* e = _first; e != nullptr; e = e->next)
+  {
+    auto const committed = e->committed_bytes.load(std::memory_order_relaxed);
+    ++result.num_stacks;
+    result.committed_bytes += committed;
+    result.used_bytes += std::min(e->used_bytes.load(std::memory_order_relaxed), committed);
+  }
+  return result;
+}
+
+auto mknejp::vmcontainer::vm::page_stack_registry::add(entry& e) noexcept -> void
+{
+  std::lock_guard<std::mutex> const lock(_mutex);
+  e.prev = nullptr;
+  e.next = _first;
+  if(_first != nullptr)
+  {
+    _first->prev = &e;
+  }
+  _first = &e;
+}
+
+auto mknejp::vmcontainer::vm::page_stack_registry::remove(entry& e) noexcept -> void
+{
+  std::lock_guard<std::mutex> const lock(_mutex);
+  (e.prev != nullptr ? e.prev->next : _first) = e.next;
+  if(e.next != nullptr)
+  {
+    e.next->prev = e.prev;
+  }
+  e.prev = nullptr;
+  e.next = nullptr;
+}
@@ -0,0 +1,190 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "vmcontainer/streaming.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__))
+#  define VMCONTAINER_STREAMING_SSE2 1
+#  include <emmintrin.h>
+#endif
+// Only GCC and Clang can compile individual functions for instruction sets not enabled for the whole build.
+#if VMCONTAINER_STREAMING_SSE2 && (defined(__GNUC__) || defined(__clang__))
+#  define VMCONTAINER_STREAMING_AVX2 1
+#  include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+  // Bytes of dest to write with regular stores until it has the given alignment.
+  auto head_bytes(void const* dest, std::size_t alignment, std::size_t num_bytes) noexcept -> std::size_t
+  {
+    auto const misalignment = reinterpret_cast<std::uintptr_t>(dest) & (alignment - 1);
+    return std::min(misalignment == 0 ? 0 : alignment - misalignment, num_bytes);
+  }
+
+  // Fill num_bytes at dest with pattern starting at byte phase of the pattern.
+  auto fill_bytes(unsigned char* dest,
+                  unsigned char const* pattern,
+                  std::size_t pattern_size,
+                  std::size_t phase,
+                  std::size_t num_bytes) noexcept -> void
+  {
+    for(auto i = std::size_t(0); i < num_bytes; ++i)
+    {
+      dest[i] = pattern[(phase + i) % pattern_size];
+    }
+  }
+
+#if VMCONTAINER_STREAMING_SSE2
+  auto stream_copy_sse2(unsigned char* dest, unsigned char const* src, std::size_t num_bytes) noexcept -> void
+  {
+    for(; num_bytes >= 64; num_bytes -= 64, dest += 64, src += 64)
+    {
+      auto const a = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src));
+      auto const b = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + 16));
+      auto const c = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + 32));
+      auto const d = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + 48));
+      _mm_stream_si128(reinterpret_cast<__m128i*>(dest), a);
+      _mm_stream_si128(reinterpret_cast<__m128i*>(dest + 16), b);
+      _mm_stream_si128(reinterpret_cast<__m128i*>(dest + 32), c);
+      _mm_stream_si128(reinterpret_cast<__m128i*>(dest + 48), d);
+    }
+    for(; num_bytes >= 16; num_bytes -= 16, dest += 16, src += 16)
+    {
+      _mm_stream_si128(reinterpret_cast<__m128i*>(dest), _mm_loadu_si128(reinterpret_cast<__m128i const*>(src)));
+    }
+    std::memcpy(dest, src, num_bytes);
+  }
+
+  // block holds 32 bytes of the pattern in the phase of dest.
+  auto stream_fill_sse2(unsigned char* dest, unsigned char const* block, std::size_t num_bytes) noexcept -> void
+  {
+    auto const a = _mm_loadu_si128(reinterpret_cast<__m128i const*>(block));
+    auto const b = _mm_loadu_si128(reinterpret_cast<__m128i const*>(block + 16));
+    for(; num_bytes >= 32; num_bytes -= 32, dest += 32)
+    {
+      _mm_stream_si128(reinterpret_cast<__m128i*>(dest), a);
+      _mm_stream_si128(reinterpret_cast<__m128i*>(dest + 16), b);
+    }
+    std::memcpy(dest, block, num_bytes);
+  }
+#endif
+
+#if VMCONTAINER_STREAMING_AVX2
+  __attribute__((target("avx2"))) auto
+  stream_copy_avx2(unsigned char* dest, unsigned char const* src, std::size_t num_bytes) noexcept -> void
+  {
+    for(; num_bytes >= 128; num_bytes -= 128, dest += 128, src += 128)
+    {
+      auto const a = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src));
+      auto const b = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + 32));
+      auto const c = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + 64));
+      auto const d = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + 96));
+      _mm256_stream_si256(reinterpret_cast<__m256i*>(dest), a);
+      _mm256_stream_si256(reinterpret_cast<__m256i*>(dest + 32), b);
+      _mm256_stream_si256(reinterpret_cast<__m256i*>(dest + 64), c);
+      _mm256_stream_si256(reinterpret_cast<__m256i*>(dest + 96), d);
+    }
+    for(; num_bytes >= 32; num_bytes -= 32, dest += 32, src += 32)
+    {
+      _mm256_stream_si256(reinterpret_cast<__m256i*>(dest), _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src)));
+    }
+    std::memcpy(dest, src, num_bytes);
+  }
+
+  __attribute__((target("avx2"))) auto
+  stream_fill_avx2(unsigned char* dest, unsigned char const* block, std::size_t num_bytes) noexcept -> void
+  {
+    auto const a = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(block));
+    for(; num_bytes >= 32; num_bytes -= 32, dest += 32)
+    {
+      _mm256_stream_si256(reinterpret_cast<__m256i*>(dest), a);
+    }
+    std::memcpy(dest, block, num_bytes);
+  }
+
+  auto has_avx2() noexcept -> bool
+  {
+    static auto const result = __builtin_cpu_supports("avx2") != 0;
+    return result;
+  }
+#endif
+
+  // Streaming stores are weakly ordered, make them visible before any later store.
+  auto fence() noexcept -> void
+  {
+#if VMCONTAINER_STREAMING_SSE2
+    _mm_sfence();
+#endif
+  }
+}
+
+auto mknejp::vmcontainer::detail::stream_copy(void* dest, void const* src, std::size_t num_bytes) noexcept -> void
+{
+  auto* d = static_cast<unsigned char*>(dest);
+  auto const* s = static_cast<unsigned char const*>(src);
+#if VMCONTAINER_STREAMING_SSE2
+  auto const alignment = std::size_t(32);
+  auto const head = head_bytes(d, alignment, num_bytes);
+  std::memcpy(d, s, head);
+  d += head;
+  s += head;
+  num_bytes -= head;
+#  if VMCONTAINER_STREAMING_AVX2
+  if(has_avx2())
+  {
+    stream_copy_avx2(d, s, num_bytes);
+    fence();
+    return;
+  }
+#  endif
+  stream_copy_sse2(d, s, num_bytes);
+  fence();
+#else
+  std::memcpy(d, s, num_bytes);
+#endif
+}
+
+auto mknejp::vmcontainer::detail::stream_fill(void* dest,
+                                              void const* pattern,
+                                              std::size_t pattern_size,
+                                              std::size_t num_bytes) noexcept -> void
+{
+  assert(can_stream_fill(pattern_size));
+  assert(num_bytes % pattern_size == 0);
+  auto* d = static_cast<unsigned char*>(dest);
+  auto const* p = static_cast<unsigned char const*>(pattern);
+#if VMCONTAINER_STREAMING_SSE2
+  auto const alignment = std::size_t(32);
+  auto const head = head_bytes(d, alignment, num_bytes);
+  fill_bytes(d, p, pattern_size, 0, head);
+  unsigned char block[32];
+  fill_bytes(block, p, pattern_size, head % pattern_size, sizeof(block));
+#  if VMCONTAINER_STREAMING_AVX2
+  if(has_avx2())
+  {
+    stream_fill_avx2(d + head, block, num_bytes - head);
+    fence();
+    return;
+  }
+#  endif
+  stream_fill_sse2(d + head, block, num_bytes - head);
+  fence();
+#else
+  unsigned char block[32];
+  fill_bytes(block, p, pattern_size, 0, sizeof(block));
+  for(; num_bytes >= sizeof(block); num_bytes -= sizeof(block), d += sizeof(block))
+  {
+    std::memcpy(d, block, sizeof(block));
+  }
+  std::memcpy(d, block, num_bytes);
+#endif
+}
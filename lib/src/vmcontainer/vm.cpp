@@ -5,6 +5,7 @@
 //
 
 #include "vmcontainer/vm.hpp"
+#include "vmcontainer/realtime.hpp"
 
 #ifdef WIN32
 #  ifndef NOMINMAX
@@ -15,16 +16,31 @@
 #  endif
 #  include <windows.h>
 #else
+#  include <fcntl.h>
 #  include <sys/mman.h>
 #  include <unistd.h>
 #endif
+#ifdef __linux__
+#  include <sys/prctl.h>
+#endif
 
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
 #include <stdexcept>
 #include <system_error>
 
+// Real-time threads must not block in the kernel, see vm::realtime_thread_scope.
+#define VMCONTAINER_ASSERT_NOT_REALTIME() \
+  assert(!is_realtime_thread() && "virtual memory system call on a real-time thread")
+
 auto mknejp::vmcontainer::vm::system_default::reserve(std::size_t num_bytes) -> void*
 {
+  VMCONTAINER_ASSERT_NOT_REALTIME();
   assert(num_bytes > 0);
 
 #ifdef WIN32
@@ -45,8 +61,128 @@ auto mknejp::vmcontainer::vm::system_default::reserve(std::size_t num_bytes) ->
 #endif
 }
 
+auto mknejp::vmcontainer::vm::system_default::reserve_aligned(std::size_t num_bytes, std::size_t alignment) -> void*
+{
+  VMCONTAINER_ASSERT_NOT_REALTIME();
+  assert(num_bytes > 0);
+  assert(alignment > page_size() && (alignment & (alignment - 1)) == 0);
+
+  auto const padded_bytes = num_bytes + alignment - page_size();
+  if(padded_bytes < num_bytes)
+  {
+    throw std::system_error(std::make_error_code(std::errc::not_enough_memory), "virtual memory reservation failed");
+  }
+  auto const align = [alignment](void* p) {
+    auto const address = reinterpret_cast<std::uintptr_t>(p);
+    return reinterpret_cast<char*>((address + alignment - 1) & ~std::uintptr_t(alignment - 1));
+  };
+#ifdef WIN32
+  // Parts of a reservation cannot be released individually, so find a suitable range and reserve it again.
+  for(auto attempt = 0; attempt < 16; ++attempt)
+  {
+    auto* const offset = reserve(padded_bytes);
+    free(offset, padded_bytes);
+    if(auto* const aligned = ::VirtualAlloc(align(offset), num_bytes, MEM_RESERVE, PAGE_NOACCESS))
+    {
+      return aligned;
+    }
+  }
+  throw std::system_error(std::make_error_code(std::errc::not_enough_memory), "virtual memory reservation failed");
+#else
+  auto* const offset = static_cast<char*>(reserve(padded_bytes));
+  auto* const aligned = align(offset);
+  auto const head_bytes = static_cast<std::size_t>(aligned - offset);
+  if(head_bytes > 0)
+  {
+    ::munmap(offset, head_bytes);
+  }
+  if(padded_bytes - head_bytes > num_bytes)
+  {
+    ::munmap(aligned + num_bytes, padded_bytes - head_bytes - num_bytes);
+  }
+  return aligned;
+#endif
+}
+
+auto mknejp::vmcontainer::vm::system_default::reserve_at(void* address, std::size_t num_bytes) -> void*
+{
+  VMCONTAINER_ASSERT_NOT_REALTIME();
+  assert(num_bytes > 0);
+
+#ifdef WIN32
+  auto const offset = ::VirtualAlloc(address, num_bytes, MEM_RESERVE, PAGE_NOACCESS);
+  if(offset == nullptr)
+  {
+    auto const err = ::GetLastError();
+    if(err == ERROR_INVALID_ADDRESS)
+    {
+      throw std::system_error(std::make_error_code(std::errc::file_exists), "address range is already in use");
+    }
+    throw std::system_error(std::error_code(err, std::system_category()), "virtual memory reservation failed");
+  }
+  return offset;
+#else
+#  ifdef MAP_FIXED_NOREPLACE
+  auto const flags = MAP_ANON | MAP_PRIVATE | MAP_FIXED_NOREPLACE;
+#  else
+  auto const flags = MAP_ANON | MAP_PRIVATE;
+#  endif
+  auto const offset = ::mmap(address, num_bytes, PROT_NONE, flags, 0, 0);
+  if(offset == MAP_FAILED)
+  {
+    if(errno == EEXIST)
+    {
+      throw std::system_error(std::make_error_code(std::errc::file_exists), "address range is already in use");
+    }
+    throw std::system_error(std::error_code(errno, std::system_category()), "virtual memory reservation failed");
+  }
+  if(offset != address)
+  {
+    // Kernels without MAP_FIXED_NOREPLACE treat the address as a hint only.
+    ::munmap(offset, num_bytes);
+    throw std::system_error(std::make_error_code(std::errc::file_exists), "address range is already in use");
+  }
+  return offset;
+#endif
+}
+
+auto mknejp::vmcontainer::vm::system_default::extend(void* offset, std::size_t num_bytes) -> bool
+{
+  VMCONTAINER_ASSERT_NOT_REALTIME();
+  assert(num_bytes > 0);
+
+#ifdef WIN32
+  // A second VirtualAlloc() region cannot be released together with the original one by VirtualFree(MEM_RELEASE).
+  (void)offset;
+  return false;
+#else
+#  ifdef MAP_FIXED_NOREPLACE
+  auto const flags = MAP_ANON | MAP_PRIVATE | MAP_FIXED_NOREPLACE;
+#  else
+  auto const flags = MAP_ANON | MAP_PRIVATE;
+#  endif
+  auto const result = ::mmap(offset, num_bytes, PROT_NONE, flags, 0, 0);
+  if(result == MAP_FAILED)
+  {
+    if(errno == EEXIST)
+    {
+      return false;
+    }
+    throw std::system_error(std::error_code(errno, std::system_category()), "virtual memory reservation failed");
+  }
+  if(result != offset)
+  {
+    // Kernels without MAP_FIXED_NOREPLACE treat the address as a hint only.
+    ::munmap(result, num_bytes);
+    return false;
+  }
+  return true;
+#endif
+}
+
 auto mknejp::vmcontainer::vm::system_default::free(void* offset, std::size_t num_bytes) -> void
 {
+  VMCONTAINER_ASSERT_NOT_REALTIME();
 #ifdef WIN32
   auto const result = ::VirtualFree(offset, 0, MEM_RELEASE);
   (void)result;
@@ -60,6 +196,7 @@ auto mknejp::vmcontainer::vm::system_default::free(void* offset, std::size_t num
 
 auto mknejp::vmcontainer::vm::system_default::commit(void* offset, std::size_t num_bytes) -> void
 {
+  VMCONTAINER_ASSERT_NOT_REALTIME();
   assert(num_bytes > 0);
 
 #ifdef WIN32
@@ -79,6 +216,7 @@ auto mknejp::vmcontainer::vm::system_default::commit(void* offset, std::size_t n
 
 auto mknejp::vmcontainer::vm::system_default::decommit(void* offset, std::size_t num_bytes) -> void
 {
+  VMCONTAINER_ASSERT_NOT_REALTIME();
 #ifdef WIN32
   auto const result = ::VirtualFree(offset, num_bytes, MEM_DECOMMIT);
   (void)result;
@@ -93,6 +231,353 @@ auto mknejp::vmcontainer::vm::system_default::decommit(void* offset, std::size_t
 #endif
 }
 
+auto mknejp::vmcontainer::vm::system_default::move_pages(void* from, void* to, std::size_t num_bytes) -> void
+{
+  VMCONTAINER_ASSERT_NOT_REALTIME();
+  assert(num_bytes > 0);
+
+#if defined(MREMAP_FIXED) && defined(MREMAP_MAYMOVE) && defined(MREMAP_DONTUNMAP)
+  // Keeps the source range mapped so no other thread can grab the address range in the meantime. Without
+  // MREMAP_DONTUNMAP the hole left behind by mremap() could only be plugged racing other threads' mmap(), so copy.
+  if(::mremap(from, num_bytes, num_bytes, MREMAP_MAYMOVE | MREMAP_FIXED | MREMAP_DONTUNMAP, to) != MAP_FAILED)
+  {
+    decommit(from, num_bytes);
+    return;
+  }
+  // The range may span more than one mapping, or the kernel is too old, fall through and copy instead.
+#endif
+  commit(to, num_bytes);
+  std::memcpy(to, from, num_bytes);
+  decommit(from, num_bytes);
+}
+
+#ifdef __linux__
+namespace
+{
+  // Count the pages in [first, last) that are present or swapped according to /proc/self/pagemap.
+  // Returns false if pagemap is not readable.
+  auto count_touched_pages(std::uintptr_t first, std::uintptr_t last, std::size_t page_size, std::size_t& touched)
+    -> bool
+  {
+    auto const fd = ::open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+    if(fd < 0)
+    {
+      return false;
+    }
+    auto entries = std::vector<std::uint64_t>(512);
+    auto result = true;
+    for(auto page = first / page_size; page < last / page_size;)
+    {
+      auto const n = std::min<std::size_t>(entries.size(), last / page_size - page);
+      auto const num_bytes = n * sizeof(std::uint64_t);
+      if(::pread(fd, entries.data(), num_bytes, static_cast<off_t>(page * sizeof(std::uint64_t)))
+         != static_cast<ssize_t>(num_bytes))
+      {
+        result = false;
+        break;
+      }
+      touched += static_cast<std::size_t>(std::count_if(entries.begin(), entries.begin() + n, [](std::uint64_t e) {
+        return (e & (std::uint64_t(3) << 62)) != 0;
+      }));
+      page += n;
+    }
+    ::close(fd);
+    return result;
+  }
+
+  // Sum AnonHugePages of the mappings intersecting [first, last) in /proc/self/smaps, clamped to the overlap.
+  auto count_huge_pages(std::uintptr_t first, std::uintptr_t last, std::size_t page_size) -> std::size_t
+  {
+    auto* const file = std::fopen("/proc/self/smaps", "re");
+    if(file == nullptr)
+    {
+      return 0;
+    }
+    auto huge_bytes = std::size_t(0);
+    auto overlap = std::size_t(0);
+    char line[512];
+    while(std::fgets(line, sizeof(line), file))
+    {
+      unsigned long long start = 0;
+      unsigned long long end = 0;
+      unsigned long long kilobytes = 0;
+      if(std::sscanf(line, "%llx-%llx ", &start, &end) == 2)
+      {
+        auto const a = std::max<std::uintptr_t>(first, static_cast<std::uintptr_t>(start));
+        auto const b = std::min<std::uintptr_t>(last, static_cast<std::uintptr_t>(end));
+        overlap = a < b ? b - a : 0;
+      }
+      else if(overlap > 0 && std::sscanf(line, "AnonHugePages: %llu kB", &kilobytes) == 1)
+      {
+        huge_bytes += std::min<std::size_t>(overlap, static_cast<std::size_t>(kilobytes) * 1024);
+      }
+    }
+    std::fclose(file);
+    return huge_bytes / page_size;
+  }
+}
+#endif
+
+auto mknejp::vmcontainer::vm::system_default::residency(void const* offset, std::size_t num_bytes) -> page_residency
+{
+  VMCONTAINER_ASSERT_NOT_REALTIME();
+  auto result = page_residency();
+  if(num_bytes == 0)
+  {
+    return result;
+  }
+#ifdef WIN32
+  (void)offset;
+  throw std::system_error(std::make_error_code(std::errc::not_supported), "residency is not supported");
+#else
+  auto const first = reinterpret_cast<std::uintptr_t>(offset) / page_size() * page_size();
+  auto const last = reinterpret_cast<std::uintptr_t>(offset) + num_bytes;
+  auto const num_pages = (last - first + page_size() - 1) / page_size();
+#  ifdef __linux__
+  auto pages = std::vector<unsigned char>(num_pages);
+#  else
+  auto pages = std::vector<char>(num_pages);
+#  endif
+  if(::mincore(reinterpret_cast<void*>(first), last - first, pages.data()) != 0)
+  {
+    throw std::system_error(std::error_code(errno, std::system_category()), "querying residency failed");
+  }
+  result.resident_pages = static_cast<std::size_t>(
+    std::count_if(pages.begin(), pages.end(), [](auto resident) { return (resident & 1) != 0; }));
+  result.touched_pages = result.resident_pages;
+#  ifdef __linux__
+  auto const page_last = first + num_pages * page_size();
+  auto touched = std::size_t(0);
+  if(count_touched_pages(first, page_last, page_size(), touched))
+  {
+    result.touched_pages = touched;
+  }
+  result.huge_pages = std::min(count_huge_pages(first, page_last, page_size()), result.resident_pages);
+#  endif
+  return result;
+#endif
+}
+
+auto mknejp::vmcontainer::vm::system_default::lock(void* offset, std::size_t num_bytes) -> void
+{
+  VMCONTAINER_ASSERT_NOT_REALTIME();
+  assert(num_bytes > 0);
+
+#ifdef WIN32
+  if(::VirtualLock(offset, num_bytes) == 0)
+  {
+    auto const err = ::GetLastError();
+    throw std::system_error(std::error_code(err, std::system_category()), "locking pages failed");
+  }
+#else
+  // Unlike MLOCK_ONFAULT this faults in every page right away so later accesses never take a page fault.
+  if(::mlock(offset, num_bytes) != 0)
+  {
+    throw std::system_error(std::error_code(errno, std::system_category()), "locking pages failed");
+  }
+#endif
+}
+
+auto mknejp::vmcontainer::vm::system_default::unlock(void* offset, std::size_t num_bytes) -> void
+{
+  VMCONTAINER_ASSERT_NOT_REALTIME();
+
+#ifdef WIN32
+  auto const result = ::VirtualUnlock(offset, num_bytes);
+  (void)result;
+  assert(result != 0);
+#else
+  auto const result = ::munlock(offset, num_bytes);
+  (void)result;
+  assert(result == 0);
+#endif
+}
+
+auto mknejp::vmcontainer::vm::system_default::set_fork_behavior(void* offset,
+                                                                std::size_t num_bytes,
+                                                                fork_behavior behavior) -> void
+{
+  VMCONTAINER_ASSERT_NOT_REALTIME();
+  assert(num_bytes > 0);
+
+#ifdef WIN32
+  // There is no fork() on Windows.
+  (void)offset;
+  (void)num_bytes;
+  (void)behavior;
+#elif defined(__linux__)
+  auto const advise = [&](int advice) {
+    if(::madvise(offset, num_bytes, advice) != 0)
+    {
+      throw std::system_error(std::error_code(errno, std::system_category()), "setting the fork behavior failed");
+    }
+  };
+  switch(behavior)
+  {
+    case fork_behavior::copy:
+      advise(MADV_DOFORK);
+#  ifdef MADV_KEEPONFORK
+      advise(MADV_KEEPONFORK);
+#  endif
+      break;
+    case fork_behavior::dont_fork:
+#  ifdef MADV_KEEPONFORK
+      advise(MADV_KEEPONFORK);
+#  endif
+      advise(MADV_DONTFORK);
+      break;
+    case fork_behavior::wipe:
+#  ifdef MADV_WIPEONFORK
+      advise(MADV_DOFORK);
+      advise(MADV_WIPEONFORK);
+#  else
+      throw std::system_error(std::make_error_code(std::errc::not_supported), "MADV_WIPEONFORK is not supported");
+#  endif
+      break;
+  }
+#else
+  (void)offset;
+  (void)num_bytes;
+  if(behavior != fork_behavior::copy)
+  {
+    throw std::system_error(std::make_error_code(std::errc::not_supported), "fork behavior is not supported");
+  }
+#endif
+}
+
+auto mknejp::vmcontainer::vm::system_default::set_dumpable(void* offset, std::size_t num_bytes, bool dumpable) -> void
+{
+  VMCONTAINER_ASSERT_NOT_REALTIME();
+  assert(num_bytes > 0);
+
+#ifdef WIN32
+  // Minidumps only contain the memory they are asked for.
+  (void)offset;
+  (void)num_bytes;
+  (void)dumpable;
+#elif defined(MADV_DONTDUMP) || defined(MADV_NOCORE)
+#  ifdef MADV_DONTDUMP
+  auto const advice = dumpable ? MADV_DODUMP : MADV_DONTDUMP;
+#  else
+  auto const advice = dumpable ? MADV_CORE : MADV_NOCORE;
+#  endif
+  if(::madvise(offset, num_bytes, advice) != 0)
+  {
+    throw std::system_error(std::error_code(errno, std::system_category()), "setting the dump behavior failed");
+  }
+#else
+  (void)offset;
+  (void)num_bytes;
+  if(!dumpable)
+  {
+    throw std::system_error(std::make_error_code(std::errc::not_supported), "core dump exclusion is not supported");
+  }
+#endif
+}
+
+auto mknejp::vmcontainer::vm::system_default::set_name(void* offset, std::size_t num_bytes, char const* name) noexcept
+  -> bool
+{
+  VMCONTAINER_ASSERT_NOT_REALTIME();
+
+#if defined(__linux__) && defined(PR_SET_VMA)
+  return ::prctl(PR_SET_VMA,
+                 PR_SET_VMA_ANON_NAME,
+                 reinterpret_cast<unsigned long>(offset),
+                 static_cast<unsigned long>(num_bytes),
+                 reinterpret_cast<unsigned long>(name))
+         == 0;
+#else
+  (void)offset;
+  (void)num_bytes;
+  (void)name;
+  return false;
+#endif
+}
+
+auto mknejp::vmcontainer::vm::system_default::set_read_only(void* offset, std::size_t num_bytes, bool read_only)
+  -> void
+{
+  VMCONTAINER_ASSERT_NOT_REALTIME();
+  assert(num_bytes > 0);
+
+#ifdef WIN32
+  auto old_protect = DWORD();
+  if(::VirtualProtect(offset, num_bytes, read_only ? PAGE_READONLY : PAGE_READWRITE, &old_protect) == 0)
+  {
+    auto const err = ::GetLastError();
+    throw std::system_error(std::error_code(err, std::system_category()), "changing page protection failed");
+  }
+#else
+  if(::mprotect(offset, num_bytes, read_only ? PROT_READ : PROT_READ | PROT_WRITE) != 0)
+  {
+    throw std::system_error(std::error_code(errno, std::system_category()), "changing page protection failed");
+  }
+#endif
+}
+
+auto mknejp::vmcontainer::vm::system_default::set_mergeable(void* offset,
+                                                            std::size_t num_bytes,
+                                                            bool mergeable) noexcept -> bool
+{
+  VMCONTAINER_ASSERT_NOT_REALTIME();
+
+#ifdef MADV_MERGEABLE
+  return ::madvise(offset, num_bytes, mergeable ? MADV_MERGEABLE : MADV_UNMERGEABLE) == 0;
+#else
+  (void)offset;
+  (void)num_bytes;
+  (void)mergeable;
+  return false;
+#endif
+}
+
+auto mknejp::vmcontainer::vm::system_default::advise(void* offset, std::size_t num_bytes, access_hint hint) noexcept
+  -> bool
+{
+  VMCONTAINER_ASSERT_NOT_REALTIME();
+  assert(reinterpret_cast<std::uintptr_t>(offset) % page_size() == 0);
+
+#ifdef WIN32
+  (void)offset;
+  (void)num_bytes;
+  (void)hint;
+  return false;
+#else
+  auto advice = MADV_NORMAL;
+  switch(hint)
+  {
+    case access_hint::normal:
+      advice = MADV_NORMAL;
+      break;
+    case access_hint::sequential:
+      advice = MADV_SEQUENTIAL;
+      break;
+    case access_hint::random:
+      advice = MADV_RANDOM;
+      break;
+    case access_hint::will_need:
+      advice = MADV_WILLNEED;
+      break;
+    case access_hint::cold:
+#  ifdef MADV_COLD
+      advice = MADV_COLD;
+      break;
+#  else
+      return false;
+#  endif
+    case access_hint::page_out:
+#  ifdef MADV_PAGEOUT
+      advice = MADV_PAGEOUT;
+      break;
+#  else
+      return false;
+#  endif
+  }
+  return ::madvise(offset, num_bytes, advice) == 0;
+#endif
+}
+
 std::size_t const mknejp::vmcontainer::vm::system_default::_page_size =
 #ifdef WIN32
   []() {
@@ -6,8 +6,11 @@
 
 #pragma once
 
+#include "vmcontainer/vm.hpp"
+
 #include "catch.hpp"
 
+#include <cstring>
 #include <functional>
 #include <map>
 
@@ -17,9 +20,14 @@ namespace vmcontainer_test
   struct virtual_memory_system_stub
   {
     static std::function<auto(std::size_t)->void*> reserve;
+    static std::function<auto(void*, std::size_t)->void*> reserve_at;
+    static std::function<auto(std::size_t, std::size_t)->void*> reserve_aligned;
+    static std::function<auto(void*, std::size_t)->bool> extend;
     static std::function<auto(void*, std::size_t num_bytes)->void> free;
     static std::function<auto(void*, std::size_t)->void> commit;
     static std::function<auto(void*, std::size_t)->void> decommit;
+    static std::function<auto(void*, void*, std::size_t)->void> move_pages;
+    static std::function<auto(void*, std::size_t, mknejp::vmcontainer::vm::access_hint)->bool> advise;
     static std::function<auto()->size_t> page_size;
 
     static auto reset() -> void
@@ -28,9 +36,28 @@ namespace vmcontainer_test
         FAIL("virtual_memory_system_stub::reserve() called without setup");
         return nullptr;
       };
+      reserve_at = [](void*, std::size_t) -> void* {
+        FAIL("virtual_memory_system_stub::reserve_at() called without setup");
+        return nullptr;
+      };
+      reserve_aligned = [](std::size_t, std::size_t) -> void* {
+        FAIL("virtual_memory_system_stub::reserve_aligned() called without setup");
+        return nullptr;
+      };
+      extend = [](void*, std::size_t) -> bool {
+        FAIL("virtual_memory_system_stub::extend() called without setup");
+        return false;
+      };
       free = [](void*, std::size_t) { FAIL("virtual_memory_system_stub::free() called without setup"); };
       commit = [](void*, std::size_t) { FAIL("virtual_memory_system_stub::commit() called without setup"); };
       decommit = [](void*, std::size_t) { FAIL("virtual_memory_system_stub::decommit() called without setup"); };
+      move_pages = [](void*, void*, std::size_t) {
+        FAIL("virtual_memory_system_stub::move_pages() called without setup");
+      };
+      advise = [](void*, std::size_t, mknejp::vmcontainer::vm::access_hint) -> bool {
+        FAIL("virtual_memory_system_stub::advise() called without setup");
+        return false;
+      };
       page_size = []() -> std::size_t {
         FAIL("virtual_memory_system_stub::page_size() called without setup");
         return 0;
@@ -41,12 +68,23 @@ namespace vmcontainer_test
   template<typename Tag>
   std::function<auto(std::size_t)->void*> virtual_memory_system_stub<Tag>::reserve;
   template<typename Tag>
+  std::function<auto(void*, std::size_t)->void*> virtual_memory_system_stub<Tag>::reserve_at;
+  template<typename Tag>
+  std::function<auto(std::size_t, std::size_t)->void*> virtual_memory_system_stub<Tag>::reserve_aligned;
+  template<typename Tag>
+  std::function<auto(void*, std::size_t)->bool> virtual_memory_system_stub<Tag>::extend;
+  template<typename Tag>
   std::function<auto(void*, std::size_t num_bytes)->void> virtual_memory_system_stub<Tag>::free;
   template<typename Tag>
   std::function<auto(void*, std::size_t)->void> virtual_memory_system_stub<Tag>::commit;
   template<typename Tag>
   std::function<auto(void*, std::size_t)->void> virtual_memory_system_stub<Tag>::decommit;
   template<typename Tag>
+  std::function<auto(void*, void*, std::size_t)->void> virtual_memory_system_stub<Tag>::move_pages;
+  template<typename Tag>
+  std::function<auto(void*, std::size_t, mknejp::vmcontainer::vm::access_hint)->bool>
+    virtual_memory_system_stub<Tag>::advise;
+  template<typename Tag>
   std::function<auto()->size_t> virtual_memory_system_stub<Tag>::page_size;
 
   template<typename Tag>
@@ -67,6 +105,53 @@ namespace vmcontainer_test
         return block;
       };
     };
+    auto expect_reserve_aligned(void* block, std::size_t expected_size, std::size_t expected_alignment) -> void
+    {
+      vm_stub::reserve_aligned = [this, block, expected_size, expected_alignment](std::size_t num_bytes,
+                                                                                  std::size_t alignment) {
+        REQUIRE(num_bytes == expected_size);
+        REQUIRE(alignment == expected_alignment);
+        auto result = _reservations.insert(std::make_pair(block, num_bytes));
+        REQUIRE(result.second == true);
+        ++_reserve_calls;
+        return block;
+      };
+    };
+    auto expect_reserve_at(void* block, std::size_t expected_size) -> void
+    {
+      vm_stub::reserve_at = [this, block, expected_size](void* address, std::size_t num_bytes) {
+        REQUIRE(address == block);
+        REQUIRE(num_bytes == expected_size);
+        auto result = _reservations.insert(std::make_pair(block, num_bytes));
+        REQUIRE(result.second == true);
+        ++_reserve_calls;
+        return block;
+      };
+    };
+
+    auto expect_extend(void* block, void* offset, std::size_t expected_size) -> void
+    {
+      vm_stub::extend = [this, block, offset, expected_size](void* p, std::size_t num_bytes) {
+        REQUIRE(num_bytes == expected_size);
+        REQUIRE(offset == p);
+        auto it = _reservations.find(block);
+        REQUIRE(it != _reservations.end());
+        REQUIRE(static_cast<char*>(block) + it->second == p);
+        it->second += num_bytes;
+        ++_extend_calls;
+        return true;
+      };
+    };
+
+    auto expect_extend_and_fail(void* offset, std::size_t expected_size) -> void
+    {
+      vm_stub::extend = [this, offset, expected_size](void* p, std::size_t num_bytes) {
+        REQUIRE(num_bytes == expected_size);
+        REQUIRE(offset == p);
+        ++_extend_calls;
+        return false;
+      };
+    };
 
     auto expect_free(void* block) -> void
     {
@@ -108,6 +193,30 @@ namespace vmcontainer_test
       };
     };
 
+    auto expect_move_pages(void* from, void* to, std::size_t expected_size) -> void
+    {
+      vm_stub::move_pages = [this, from, to, expected_size](void* p, void* q, std::size_t num_bytes) {
+        REQUIRE(num_bytes == expected_size);
+        REQUIRE(from == p);
+        REQUIRE(to == q);
+        std::memcpy(q, p, num_bytes);
+        ++_move_pages_calls;
+      };
+    };
+
+    auto expect_advise(void* offset, std::size_t expected_size, mknejp::vmcontainer::vm::access_hint expected_hint)
+      -> void
+    {
+      vm_stub::advise = [this, offset, expected_size, expected_hint](
+                          void* p, std::size_t num_bytes, mknejp::vmcontainer::vm::access_hint hint) {
+        REQUIRE(num_bytes == expected_size);
+        REQUIRE(offset == p);
+        REQUIRE(hint == expected_hint);
+        ++_advise_calls;
+        return true;
+      };
+    };
+
     auto set_page_size(std::size_t n)
     {
       vm_stub::page_size = [n] { return n; };
@@ -115,16 +224,22 @@ namespace vmcontainer_test
 
     auto reservations() const noexcept -> std::size_t { return _reservations.size(); }
     auto reserve_calls() const noexcept -> int { return _reserve_calls; }
+    auto extend_calls() const noexcept -> int { return _extend_calls; }
     auto free_calls() const noexcept -> int { return _free_calls; }
     auto commit_calls() const noexcept -> int { return _commit_calls; }
     auto decommit_calls() const noexcept -> int { return _decommit_calls; }
+    auto move_pages_calls() const noexcept -> int { return _move_pages_calls; }
+    auto advise_calls() const noexcept -> int { return _advise_calls; }
 
   private:
     std::map<void*, std::size_t> _reservations;
 
     int _reserve_calls = 0;
+    int _extend_calls = 0;
     int _free_calls = 0;
     int _commit_calls = 0;
     int _decommit_calls = 0;
+    int _move_pages_calls = 0;
+    int _advise_calls = 0;
   };
 }
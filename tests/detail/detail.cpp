@@ -18,6 +18,10 @@ using namespace mknejp::vmcontainer;
 
 static_assert(num_bytes(5).num_bytes(1000) == 5, "");
 static_assert(num_pages(5).num_bytes(1000) == 5 * 1000, "");
+static_assert(num_pages(5).alignment(1000) == 1000, "");
+static_assert(num_pages(5).aligned_to(4096).alignment(1000) == 4096, "");
+static_assert(num_pages(5).aligned_to(512).alignment(1000) == 1000, "");
+static_assert(num_pages(5).aligned_to(4096).num_bytes(1000) == 5 * 1000, "");
 
 ///////////////////////////////////////////////////////////////////////////////
 // max_size_t
@@ -26,3 +30,6 @@ static_assert(num_pages(5).num_bytes(1000) == 5 * 1000, "");
 static_assert(max_elements(5).scaled_for_type<int>().num_bytes(1000) == 5 * sizeof(int), "");
 static_assert(max_bytes(5).scaled_for_type<int>().num_bytes(1000) == 5, "");
 static_assert(max_pages(5).scaled_for_type<int>().num_bytes(1000) == 5 * 1000, "");
+static_assert(max_elements(5).aligned_to(4096).scaled_for_type<int>().alignment(1000) == 4096, "");
+static_assert(max_bytes(5).aligned_to(4096).scaled_for_type<int>().alignment(1000) == 4096, "");
+static_assert(max_pages(5).aligned_to(4096).scaled_for_type<int>().alignment(1000) == 4096, "");
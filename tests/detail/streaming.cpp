@@ -0,0 +1,94 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "vmcontainer/streaming.hpp"
+
+#include <catch.hpp>
+
+#include <cstring>
+#include <vector>
+
+using namespace mknejp::vmcontainer::detail;
+
+///////////////////////////////////////////////////////////////////////////////
+// streaming stores
+//
+
+static_assert(can_stream_fill(1), "");
+static_assert(can_stream_fill(8), "");
+static_assert(can_stream_fill(32), "");
+static_assert(!can_stream_fill(0), "");
+static_assert(!can_stream_fill(12), "");
+static_assert(!can_stream_fill(64), "");
+
+static_assert(!use_streaming_stores<int>(16), "");
+static_assert(use_streaming_stores<int>(VMCONTAINER_STREAMING_THRESHOLD / sizeof(int)), "");
+static_assert(!use_streaming_stores<std::vector<int>>(VMCONTAINER_STREAMING_THRESHOLD), "");
+
+TEST_CASE("stream_copy() copies unaligned ranges of any size", "[detail][streaming]")
+{
+  auto src = std::vector<unsigned char>(1024);
+  for(auto i = std::size_t(0); i < src.size(); ++i)
+  {
+    src[i] = static_cast<unsigned char>(i * 7 + 3);
+  }
+  for(auto offset : {0, 1, 7, 16, 31})
+  {
+    for(auto num_bytes : {0, 1, 15, 32, 33, 127, 128, 500, 900})
+    {
+      auto dest = std::vector<unsigned char>(1024, 0xff);
+      stream_copy(dest.data() + offset, src.data() + 5, num_bytes);
+      CHECK(std::memcmp(dest.data() + offset, src.data() + 5, num_bytes) == 0);
+      // Nothing beyond the range is touched.
+      CHECK(dest[offset + num_bytes] == 0xff);
+      CHECK((offset == 0 || dest[offset - 1] == 0xff));
+    }
+  }
+}
+
+TEST_CASE("stream_fill() repeats patterns from unaligned addresses", "[detail][streaming]")
+{
+  unsigned char const pattern[32] = {1,  2,  3,  4,  5,  6,  7,  8,  9,  10, 11, 12, 13, 14, 15, 16,
+                                     17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32};
+  for(auto pattern_size : {1, 2, 4, 8, 16, 32})
+  {
+    for(auto offset : {0, 4, 8, 24})
+    {
+      for(auto count : {0, 1, 3, 17, 40})
+      {
+        auto dest = std::vector<unsigned char>(2048, 0xff);
+        auto const num_bytes = std::size_t(count * pattern_size);
+        stream_fill(dest.data() + offset, pattern, pattern_size, num_bytes);
+        for(auto i = std::size_t(0); i < num_bytes; ++i)
+        {
+          REQUIRE(dest[offset + i] == pattern[i % pattern_size]);
+        }
+        CHECK(dest[offset + num_bytes] == 0xff);
+      }
+    }
+  }
+}
+
+TEST_CASE("streaming algorithms produce the same result as the standard ones", "[detail][streaming]")
+{
+  auto const count = VMCONTAINER_STREAMING_THRESHOLD / sizeof(int) + 3;
+  auto src = std::vector<int>(count);
+  for(auto i = std::size_t(0); i < count; ++i)
+  {
+    src[i] = static_cast<int>(i);
+  }
+
+  auto dest = std::vector<int>(count + 1, -1);
+  CHECK(copy(src.data(), src.data() + count, dest.data() + 1) == dest.data() + count + 1);
+  CHECK(std::equal(src.begin(), src.end(), dest.begin() + 1));
+
+  CHECK(fill_n(dest.data(), count, 42) == dest.data() + count);
+  CHECK(std::all_of(dest.begin(), dest.end() - 1, [](int x) { return x == 42; }));
+  CHECK(dest.back() == static_cast<int>(count - 1));
+
+  CHECK(uninitialized_value_construct_contiguous_n(dest.data(), count) == dest.data() + count);
+  CHECK(std::all_of(dest.begin(), dest.end() - 1, [](int x) { return x == 0; }));
+}
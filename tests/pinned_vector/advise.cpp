@@ -0,0 +1,66 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "pinned_vector_test.hpp"
+
+#include "catch.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+using namespace mknejp::vmcontainer;
+using namespace vmcontainer_test;
+
+TEST_CASE("pinned_vector::advise() applies to the pages holding the elements", "[pinned_vector][advise]")
+{
+  struct tag
+  {};
+  auto alloc = tracking_allocator<tag>();
+  using traits = pinned_vector_test_traits<decltype(alloc)>;
+
+  int pages[4][4];
+  alloc.set_page_size(sizeof(pages[0]));
+  alloc.expect_reserve(pages, sizeof(pages));
+  alloc.expect_commit(pages, sizeof(pages));
+  alloc.expect_free(pages);
+
+  auto v = pinned_vector<int, traits>(max_pages(4), 14);
+  REQUIRE(v.capacity() == 16);
+
+  alloc.expect_advise(pages[1], 2 * sizeof(pages[0]), vm::access_hint::cold);
+  CHECK(v.advise(v.begin() + 5, v.begin() + 9, vm::access_hint::cold));
+  CHECK(alloc.advise_calls() == 1);
+
+  alloc.expect_advise(pages[3], sizeof(pages[0]), vm::access_hint::sequential);
+  CHECK(v.advise(v.begin() + 13, v.end(), vm::access_hint::sequential));
+  CHECK(alloc.advise_calls() == 2);
+
+  CHECK(v.advise(v.begin() + 5, v.begin() + 5, vm::access_hint::random));
+  CHECK(alloc.advise_calls() == 2);
+}
+
+TEST_CASE("pinned_vector::advise() preserves the elements", "[pinned_vector][advise]")
+{
+  auto v = pinned_vector<int>(max_elements(100000), 100000);
+  std::iota(v.begin(), v.end(), 0);
+  auto const hint = GENERATE(vm::access_hint::normal,
+                             vm::access_hint::sequential,
+                             vm::access_hint::random,
+                             vm::access_hint::will_need,
+                             vm::access_hint::cold,
+                             vm::access_hint::page_out);
+  auto const supported = v.advise(v.begin() + 1000, v.end(), hint);
+#ifdef __linux__
+  if(hint != vm::access_hint::cold && hint != vm::access_hint::page_out)
+  {
+    CHECK(supported);
+  }
+#else
+  (void)supported;
+#endif
+  auto expected = 0;
+  CHECK(std::all_of(v.begin(), v.end(), [&](int x) { return x == expected++; }));
+}
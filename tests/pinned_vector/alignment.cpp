@@ -0,0 +1,118 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "vmcontainer/padded.hpp"
+#include "vmcontainer/pinned_vector.hpp"
+
+#include "catch.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+using namespace mknejp::vmcontainer;
+
+namespace
+{
+  struct alignas(64 * 1024) block
+  {
+    char bytes[100];
+  };
+
+  // Records whether it was copied or constructed from something else.
+  struct tracked
+  {
+    tracked() = default;
+    tracked(tracked const&) : copied(true) {}
+    template<typename U>
+    explicit tracked(U&&) : converted(true)
+    {}
+
+    bool copied = false;
+    bool converted = false;
+  };
+
+  auto is_aligned(void const* p, std::size_t alignment) -> bool
+  {
+    return reinterpret_cast<std::uintptr_t>(p) % alignment == 0;
+  }
+}
+
+static_assert(sizeof(padded<char>) == cache_line_size, "");
+static_assert(alignof(padded<char>) == cache_line_size, "");
+static_assert(sizeof(padded<char[100]>) == 2 * cache_line_size, "");
+static_assert(sizeof(padded<int, 4096>) == 4096, "");
+static_assert(std::is_trivially_copyable<padded<int>>::value, "");
+static_assert(std::is_trivially_default_constructible<padded<int>>::value, "");
+static_assert(std::is_constructible<padded<int>, int>::value, "");
+static_assert(!std::is_convertible<int, padded<int>>::value, "");
+
+TEST_CASE("pinned_vector with an over-aligned value_type", "[pinned_vector][alignment]")
+{
+  auto v = pinned_vector<block>(max_elements(10));
+  v.resize(10);
+  for(auto const& x : v)
+  {
+    CHECK(is_aligned(&x, alignof(block)));
+  }
+
+  SECTION("keeps the alignment when copied")
+  {
+    auto copy = v;
+    CHECK(is_aligned(copy.data(), alignof(block)));
+  }
+
+  SECTION("keeps a larger requested alignment when copied or split")
+  {
+    auto const alignment = std::size_t(1) << 21;
+    auto w = pinned_vector<block>(max_elements(10).aligned_to(alignment), 2);
+    auto const copy = w;
+    CHECK(is_aligned(copy.data(), alignment));
+    auto const tail = w.split_off(1);
+    CHECK(is_aligned(tail.data(), alignment));
+  }
+
+  SECTION("keeps the alignment when relocated")
+  {
+    v.relocate_to_larger_reservation(max_elements(20));
+    CHECK(is_aligned(v.data(), alignof(block)));
+  }
+
+  SECTION("a larger requested alignment wins")
+  {
+    auto const alignment = std::size_t(1) << 21;
+    auto w = pinned_vector<block>(max_elements(10).aligned_to(alignment));
+    w.resize(1);
+    CHECK(is_aligned(w.data(), alignment));
+  }
+}
+
+TEST_CASE("pinned_vector<padded<T>> puts every element on its own cache line", "[pinned_vector][alignment]")
+{
+  auto v = pinned_vector<padded<std::atomic<int>>>(max_elements(100));
+  for(auto i = 0; i < 100; ++i)
+  {
+    v.emplace_back(i);
+  }
+  for(std::size_t i = 0; i < v.size(); ++i)
+  {
+    CHECK(is_aligned(&v[i], cache_line_size));
+    CHECK(v[i].value.load() == static_cast<int>(i));
+  }
+  CHECK(reinterpret_cast<char*>(&v[1]) - reinterpret_cast<char*>(&v[0]) == cache_line_size);
+
+  std::atomic<int>& counter = v[5];
+  ++counter;
+  CHECK(v[5].value.load() == 6);
+}
+
+TEST_CASE("padded<T> copies through the copy constructor", "[pinned_vector][alignment]")
+{
+  auto x = padded<tracked>();
+  auto const y = x;
+  CHECK(y.value.copied);
+  CHECK(!y.value.converted);
+}
@@ -22,6 +22,30 @@ TEST_CASE("pinned_vector::page_size() returns the system page size", "[pinned_ve
   CHECK(v.page_size() == vm::system_default::page_size());
 }
 
+TEST_CASE("pinned_vector with an aligned reservation", "[pinned_vector][capacity]")
+{
+  auto const alignment = std::size_t(1) << 21;
+  auto v = pinned_vector<int>(max_elements(1000).aligned_to(alignment));
+  v.push_back(1);
+  CHECK(reinterpret_cast<std::uintptr_t>(v.data()) % alignment == 0);
+  CHECK(v.max_size() == round_up(1000 * sizeof(int), v.page_size()) / sizeof(int));
+}
+
+TEST_CASE("pinned_vector::residency() reports the pages holding elements", "[pinned_vector][capacity]")
+{
+  auto v = pinned_vector<char>(max_pages(16));
+  auto const page_size = v.page_size();
+  v.reserve(8 * page_size);
+  CHECK(v.residency().resident_pages == 0);
+
+  v.resize(2 * page_size + 1, 'x');
+  CHECK(v.residency().resident_pages == 3);
+  CHECK(v.residency().touched_pages == 3);
+  CHECK(v.residency(0, v.size()).resident_pages == 3);
+  CHECK(v.residency(page_size + 1, 1).resident_pages == 1);
+  CHECK(v.residency(page_size - 1, 2).resident_pages == 2);
+}
+
 TEST_CASE("pinned_vector::reserve() grows the capacity", "[pinned_vector][capacity]")
 {
   auto v = pinned_vector<int>(max_pages(10));
@@ -291,3 +315,58 @@ TEST_CASE("pinned_vector::resize() has strong exception guarantee if committing
   REQUIRE(v.capacity() == 4);
   REQUIRE(capture_value_state(v) == state);
 }
+
+TEST_CASE("pinned_vector::try_grow_max_size() grows max_size() without moving the elements",
+          "[pinned_vector][capacity]")
+{
+  struct tag
+  {};
+  auto alloc = tracking_allocator<tag>();
+  using traits = pinned_vector_test_traits<decltype(alloc)>;
+
+  char pages[4 * 4 * sizeof(int)];
+  alloc.set_page_size(4 * sizeof(int));
+  alloc.expect_reserve(pages, 4 * sizeof(int));
+  alloc.expect_commit(pages, 4 * sizeof(int));
+  alloc.expect_free(pages);
+
+  auto v = pinned_vector<int, traits>(max_pages(1), {1, 2, 3});
+  REQUIRE(v.max_size() == 4);
+
+  SECTION("success")
+  {
+    alloc.expect_extend(pages, &pages[0] + 4 * sizeof(int), 2 * 4 * sizeof(int));
+    auto state = capture_value_state(v);
+    REQUIRE(v.try_grow_max_size(max_elements(10)) == true);
+    CHECK(v.max_size() == 12);
+    CHECK(v.data() == state.data);
+    CHECK(v.end() == state.end);
+    CHECK(std::equal(v.begin(), v.end(), std::begin({1, 2, 3})));
+  }
+  SECTION("failure")
+  {
+    alloc.expect_extend_and_fail(&pages[0] + 4 * sizeof(int), 4 * sizeof(int));
+    auto state = capture_value_state(v);
+    REQUIRE(v.try_grow_max_size(max_pages(2)) == false);
+    CHECK(capture_value_state(v) == state);
+  }
+}
+
+TEST_CASE("pinned_vector::try_grow_max_size() either extends in place or leaves the container untouched",
+          "[pinned_vector][capacity]")
+{
+  auto v = pinned_vector<int>(max_pages(1), {1, 2, 3});
+  auto const page_size = v.page_size();
+  auto state = capture_value_state(v);
+  if(v.try_grow_max_size(max_pages(4)))
+  {
+    CHECK(v.max_size() == 4 * page_size / sizeof(int));
+    CHECK(v.data() == state.data);
+    v.resize(v.max_size(), 7);
+    CHECK(v.back() == 7);
+  }
+  else
+  {
+    CHECK(capture_value_state(v) == state);
+  }
+}
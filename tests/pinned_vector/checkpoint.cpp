@@ -0,0 +1,145 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "vmcontainer/checkpoint.hpp"
+
+#include "catch.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <system_error>
+
+#ifndef WIN32
+#  include <stdio.h>
+#  include <unistd.h>
+#endif
+
+using namespace mknejp::vmcontainer;
+
+#ifndef WIN32
+
+namespace
+{
+  struct point
+  {
+    std::int32_t x;
+    std::int32_t y;
+  };
+
+  // Anonymous temporary file that is deleted when going out of scope.
+  class temp_fd
+  {
+  public:
+    temp_fd() : _file(::tmpfile()) { REQUIRE(_file != nullptr); }
+    temp_fd(temp_fd const&) = delete;
+    auto operator=(temp_fd const&) -> temp_fd& = delete;
+    ~temp_fd() { ::fclose(_file); }
+
+    auto get() const noexcept -> int { return ::fileno(_file); }
+
+  private:
+    FILE* _file;
+  };
+}
+
+TEST_CASE("load() restores what save() wrote", "[pinned_vector][checkpoint]")
+{
+  temp_fd const file;
+  auto v = pinned_vector<point>(max_elements(100000));
+  for(std::int32_t i = 0; i < 30000; ++i)
+  {
+    v.push_back({i, -i});
+  }
+  save(v, file.get());
+
+  auto w = load<point>(file.get(), max_elements(100000));
+  CHECK(w.data() != v.data());
+  REQUIRE(w.size() == v.size());
+  CHECK(w.max_size() == v.max_size());
+  CHECK(w.capacity() >= w.size());
+  for(std::int32_t i = 0; i < 30000; ++i)
+  {
+    REQUIRE(w[static_cast<std::size_t>(i)].x == i);
+    REQUIRE(w[static_cast<std::size_t>(i)].y == -i);
+  }
+}
+
+TEST_CASE("a loaded pinned_vector can be modified without changing the file", "[pinned_vector][checkpoint]")
+{
+  temp_fd const file;
+  auto v = pinned_vector<int>(max_pages(16));
+  v.resize(1000);
+  std::iota(v.begin(), v.end(), 0);
+  save(v, file.get());
+
+  {
+    auto w = load<int>(file.get(), max_pages(16));
+    std::fill(w.begin(), w.end(), -1);
+    w.resize(w.max_size(), -2);
+    CHECK(w.back() == -2);
+    w.clear();
+    w.shrink_to_fit();
+  }
+
+  auto w = load<int>(file.get(), max_pages(1));
+  CHECK(w == v);
+}
+
+TEST_CASE("load() reserves at least the size of the checkpoint", "[pinned_vector][checkpoint]")
+{
+  temp_fd const file;
+  auto v = pinned_vector<int>(max_pages(4));
+  v.resize(v.max_size(), 3);
+  save(v, file.get());
+
+  auto w = load<int>(file.get(), max_elements(1));
+  CHECK(w.max_size() == v.max_size());
+  CHECK(w == v);
+}
+
+TEST_CASE("saving and loading an empty pinned_vector", "[pinned_vector][checkpoint]")
+{
+  temp_fd const file;
+  save(pinned_vector<int>(), file.get());
+  auto w = load<int>(file.get(), max_elements(10));
+  CHECK(w.empty());
+  w.push_back(1);
+  CHECK(w.front() == 1);
+}
+
+TEST_CASE("load() rejects mismatching checkpoints", "[pinned_vector][checkpoint]")
+{
+  temp_fd const file;
+  SECTION("not a checkpoint")
+  {
+    REQUIRE(::write(file.get(), "hello", 5) == 5);
+    CHECK_THROWS_AS(load<int>(file.get(), max_elements(10)), std::system_error);
+  }
+  SECTION("different element type")
+  {
+    save(pinned_vector<int>(max_elements(10), {1, 2, 3}), file.get());
+    CHECK_THROWS_AS(load<point>(file.get(), max_elements(10)), std::system_error);
+    CHECK_THROWS_AS(load<char>(file.get(), max_elements(10)), std::system_error);
+  }
+  SECTION("truncated")
+  {
+    save(pinned_vector<int>(max_elements(10), {1, 2, 3}), file.get());
+    REQUIRE(::ftruncate(file.get(), 100) == 0);
+    CHECK_THROWS_AS(load<int>(file.get(), max_elements(10)), std::system_error);
+  }
+  SECTION("count overflows the size")
+  {
+    save(pinned_vector<int>(max_elements(10), {1, 2, 3}), file.get());
+    // count * sizeof(int) wraps around to 4 bytes, which the file easily covers.
+    auto const count = (std::numeric_limits<std::uint64_t>::max() / sizeof(int)) + 2;
+    auto const count_offset = 32; // checkpoint_header::count
+    REQUIRE(::pwrite(file.get(), &count, sizeof(count), count_offset) == sizeof(count));
+    CHECK_THROWS_AS(load<int>(file.get(), max_elements(10)), std::system_error);
+  }
+}
+
+#endif
@@ -0,0 +1,178 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "vmcontainer/budget.hpp"
+#include "vmcontainer/dump_policy.hpp"
+#include "vmcontainer/fork_policy.hpp"
+#include "vmcontainer/instrumented.hpp"
+#include "vmcontainer/memory_tag.hpp"
+#include "vmcontainer/pinned_vector.hpp"
+
+#include "catch.hpp"
+
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+
+#ifdef __linux__
+#  include <sys/wait.h>
+#  include <unistd.h>
+#endif
+
+using namespace mknejp::vmcontainer;
+
+#ifdef __linux__
+
+namespace
+{
+  // The VmFlags of the mapping containing p in /proc/self/smaps.
+  auto vm_flags(void const* p) -> std::string
+  {
+    auto* const file = std::fopen("/proc/self/smaps", "re");
+    REQUIRE(file != nullptr);
+    auto const address = reinterpret_cast<std::uintptr_t>(p);
+    auto found = false;
+    auto result = std::string();
+    char line[512];
+    while(std::fgets(line, sizeof(line), file))
+    {
+      unsigned long long start = 0;
+      unsigned long long end = 0;
+      if(std::sscanf(line, "%llx-%llx ", &start, &end) == 2)
+      {
+        found = start <= address && address < end;
+      }
+      else if(found && std::strncmp(line, "VmFlags:", 8) == 0)
+      {
+        result = line + 8;
+        break;
+      }
+    }
+    std::fclose(file);
+    return result;
+  }
+
+  // Fork a child that writes to p and return the signal that terminated it, or 0.
+  auto write_from_child(int* p) -> int
+  {
+    auto const child = ::fork();
+    REQUIRE(child >= 0);
+    if(child == 0)
+    {
+      // Catch installs its own signal handlers.
+      std::signal(SIGSEGV, SIG_DFL);
+      *p = -1;
+      ::_exit(0);
+    }
+    auto status = 0;
+    REQUIRE(::waitpid(child, &status, 0) == child);
+    return WIFSIGNALED(status) ? WTERMSIG(status) : 0;
+  }
+
+  using wrapped_system = vm::instrumented_system<
+    vm::tagged_system<vm::budgeted_system<vm::dump_policy_system<vm::fork_policy_system<>>>>>;
+
+  struct wrapped_traits
+  {
+    using storage_type = vm::page_stack_base<wrapped_system>;
+    using growth_factor = pinned_vector_traits::growth_factor;
+  };
+}
+
+TEST_CASE("pinned_vector::freeze()", "[pinned_vector][freeze]")
+{
+  auto const page_size = vm::system_default::page_size();
+  auto v = pinned_vector<int>(max_elements(100000));
+  v.resize(10000);
+  std::iota(v.begin(), v.end(), 0);
+  v.reserve(50000);
+  REQUIRE(!v.frozen());
+
+  CHECK(v.freeze());
+  CHECK(v.frozen());
+  CHECK(v.capacity() * sizeof(int) == detail::round_up(v.size() * sizeof(int), page_size));
+  CHECK(v[9999] == 9999);
+  CHECK(vm_flags(v.data()).find(" wr") == std::string::npos);
+  CHECK(write_from_child(&v[5000]) == SIGSEGV);
+
+  SECTION("thaw() makes the elements writable again")
+  {
+    v.thaw();
+    CHECK(!v.frozen());
+    CHECK(write_from_child(&v[5000]) == 0);
+    v.push_back(10000);
+    v[0] = -1;
+    CHECK(v.size() == 10001);
+    CHECK(v[0] == -1);
+  }
+
+  SECTION("copies are not frozen")
+  {
+    auto w = v;
+    CHECK(!w.frozen());
+    w.push_back(10000);
+    CHECK(w.size() == v.size() + 1);
+  }
+
+  SECTION("moves stay frozen")
+  {
+    auto const w = std::move(v);
+    CHECK(w.frozen());
+    CHECK(!v.frozen());
+  }
+
+  SECTION("move assignment keeps the target frozen")
+  {
+    auto w = pinned_vector<int>(max_elements(100), 10);
+    w = std::move(v);
+    CHECK(w.frozen());
+    CHECK(!v.frozen());
+    CHECK(write_from_child(&w[5000]) == SIGSEGV);
+    w.thaw();
+    w.push_back(10000);
+    CHECK(w.size() == 10001);
+  }
+
+  SECTION("swap exchanges the frozen state")
+  {
+    auto w = pinned_vector<int>(max_elements(100), 10);
+    swap(v, w);
+    CHECK(w.frozen());
+    CHECK(!v.frozen());
+    CHECK(write_from_child(&w[5000]) == SIGSEGV);
+    v.push_back(10);
+    CHECK(v.size() == 11);
+    w.thaw();
+    CHECK(write_from_child(&w[5000]) == 0);
+  }
+}
+
+TEST_CASE("pinned_vector::freeze() works through wrapped systems", "[pinned_vector][freeze]")
+{
+  auto v = pinned_vector<int, wrapped_traits>(max_elements(100000), 10000);
+  std::iota(v.begin(), v.end(), 0);
+  v.freeze();
+  CHECK(v.frozen());
+  CHECK(vm_flags(v.data()).find(" wr") == std::string::npos);
+  CHECK(write_from_child(&v[5000]) == SIGSEGV);
+  v.thaw();
+  CHECK(write_from_child(&v[5000]) == 0);
+}
+
+TEST_CASE("pinned_vector::freeze(true) makes the pages mergeable", "[pinned_vector][freeze]")
+{
+  auto v = pinned_vector<int>(max_elements(100000), 50000);
+  if(v.freeze(true))
+  {
+    CHECK(vm_flags(v.data()).find(" mg") != std::string::npos);
+    v.thaw();
+    CHECK(vm_flags(v.data()).find(" mg") == std::string::npos);
+  }
+}
+
+#endif
@@ -0,0 +1,215 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "vmcontainer/offset_ptr.hpp"
+#include "vmcontainer/pinned_vector.hpp"
+
+#include "catch.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+using namespace mknejp::vmcontainer;
+
+namespace
+{
+  struct node;
+
+  struct graph
+  {
+    static auto nodes() -> pinned_vector<node>&;
+    static auto base() noexcept -> void*;
+  };
+
+  struct node
+  {
+    int value;
+    offset_ptr<node, graph> next;
+  };
+
+  struct relative_node
+  {
+    int value;
+    relative_ptr<relative_node> next;
+  };
+
+  // Link the elements of v in order.
+  auto link(pinned_vector<relative_node>& v) -> void
+  {
+    for(std::size_t i = 0; i < v.size(); ++i)
+    {
+      v[i].value = static_cast<int>(i);
+      v[i].next = i + 1 < v.size() ? &v[i + 1] : nullptr;
+    }
+  }
+
+  auto count_links(relative_node const* first) -> int
+  {
+    auto n = 0;
+    for(auto const* p = first; p; p = p->next.get())
+    {
+      REQUIRE(p->value == n++);
+    }
+    return n;
+  }
+
+  auto graph::nodes() -> pinned_vector<node>&
+  {
+    static auto nodes = pinned_vector<node>(max_pages(16));
+    return nodes;
+  }
+
+  auto graph::base() noexcept -> void*
+  {
+    return nodes().data();
+  }
+}
+
+static_assert(sizeof(offset_ptr<node, graph>) == sizeof(std::uint32_t), "");
+static_assert(sizeof(offset_ptr<node, graph, std::uint16_t>) == sizeof(std::uint16_t), "");
+static_assert(sizeof(node) == 2 * sizeof(std::uint32_t), "");
+static_assert(std::is_trivially_copyable<offset_ptr<node, graph>>::value, "");
+static_assert(std::is_nothrow_default_constructible<offset_ptr<node, graph>>::value, "");
+static_assert(std::is_convertible<offset_ptr<node, graph>, offset_ptr<node const, graph>>::value, "");
+static_assert(!std::is_convertible<offset_ptr<node const, graph>, offset_ptr<node, graph>>::value, "");
+
+TEST_CASE("offset_ptr", "[offset_ptr]")
+{
+  graph::nodes().clear();
+  graph::nodes().resize(100);
+
+  SECTION("default constructed is null")
+  {
+    auto p = offset_ptr<node, graph>();
+    CHECK(!p);
+    CHECK(p.get() == nullptr);
+    CHECK(p == nullptr);
+    CHECK(p == offset_ptr<node, graph>(nullptr));
+    CHECK(offset_ptr<node, graph>(static_cast<node*>(nullptr)) == p);
+  }
+
+  SECTION("stores offsets in units of the alignment")
+  {
+    auto first = offset_ptr<node, graph>(&graph::nodes()[0]);
+    auto last = offset_ptr<node, graph>(&graph::nodes()[99]);
+    CHECK(first);
+    CHECK(first.offset() == 0);
+    CHECK(first.get() == &graph::nodes()[0]);
+    CHECK(last.offset() == 99 * sizeof(node) / alignof(node));
+    CHECK(last.get() == &graph::nodes()[99]);
+    CHECK(first != last);
+    CHECK(offset_ptr<node, graph>::from_offset(last.offset()) == last);
+
+    auto const_last = offset_ptr<node const, graph>(last);
+    CHECK(const_last.get() == &graph::nodes()[99]);
+  }
+
+  SECTION("links survive moving the region")
+  {
+    for(std::size_t i = 0; i + 1 < graph::nodes().size(); ++i)
+    {
+      graph::nodes()[i] = {static_cast<int>(i), offset_ptr<node, graph>(&graph::nodes()[i + 1])};
+    }
+    graph::nodes().back() = {99, nullptr};
+
+    auto copy = pinned_vector<node>(max_pages(16));
+    copy.resize(graph::nodes().size());
+    std::memcpy(copy.data(), graph::nodes().data(), copy.size() * sizeof(node));
+    auto const* const old_base = graph::base();
+    swap(graph::nodes(), copy);
+    REQUIRE(graph::base() != old_base);
+
+    auto expected = 0;
+    for(auto p = offset_ptr<node, graph>(&graph::nodes()[0]); p; p = p->next)
+    {
+      REQUIRE(p->value == expected++);
+    }
+    CHECK(expected == 100);
+  }
+}
+
+TEST_CASE("offset_ptr into the region of an object", "[offset_ptr]")
+{
+  using pointer = offset_ptr<int, vm::reservation>;
+  auto const r1 = vm::reservation(num_pages(1));
+  auto const r2 = vm::reservation(num_pages(1));
+  auto* const x1 = static_cast<int*>(r1.base()) + 5;
+  auto* const x2 = static_cast<int*>(r2.base()) + 5;
+
+  auto const p = pointer(x1, r1);
+  CHECK(p.offset() == 5);
+  CHECK(p.get(r1) == x1);
+  CHECK(p.get(r2) == x2);
+  CHECK(pointer(x2, r2) == p);
+  CHECK(!pointer(nullptr, r1));
+  CHECK(pointer(nullptr, r1).get(r1) == nullptr);
+}
+
+static_assert(sizeof(relative_ptr<relative_node>) == sizeof(std::int32_t), "");
+static_assert(sizeof(relative_ptr<relative_node, std::int16_t>) == sizeof(std::int16_t), "");
+static_assert(std::is_trivially_copyable<relative_node>::value, "");
+static_assert(std::is_convertible<relative_ptr<node>, relative_ptr<node const>>::value, "");
+static_assert(!std::is_convertible<relative_ptr<node const>, relative_ptr<node>>::value, "");
+
+TEST_CASE("relative_ptr", "[offset_ptr]")
+{
+  SECTION("default constructed is null")
+  {
+    auto p = relative_ptr<int>();
+    CHECK(!p);
+    CHECK(p.get() == nullptr);
+    CHECK(p == nullptr);
+    CHECK(relative_ptr<int>(static_cast<int*>(nullptr)) == p);
+  }
+
+  SECTION("copies keep the distance")
+  {
+    struct pair
+    {
+      relative_ptr<int> p;
+      relative_ptr<int const> q;
+      int x;
+    };
+    auto v = pinned_vector<pair>(max_pages(1), 2);
+    v[0].p = &v[0].x;
+    CHECK(v[0].p.get() == &v[0].x);
+    v[0].q = v[0].p.get();
+    CHECK(v[0].q.get() == &v[0].x);
+    CHECK(v[0].q.offset() != v[0].p.offset());
+    v[1] = v[0];
+    CHECK(v[1].p.get() == &v[1].x);
+    CHECK(v[1].p.offset() == v[0].p.offset());
+    v[1].p = v[0].p.get();
+    CHECK(v[1].p.get() == &v[0].x);
+    CHECK(v[1].p == v[0].p);
+    v[1].q = nullptr;
+    CHECK(!v[1].q);
+  }
+
+  SECTION("works in regions of different container instances")
+  {
+    auto a = pinned_vector<relative_node>(max_pages(16), 100);
+    auto b = pinned_vector<relative_node>(max_pages(16), 50);
+    link(a);
+    link(b);
+    CHECK(count_links(a.data()) == 100);
+    CHECK(count_links(b.data()) == 50);
+  }
+
+  SECTION("links survive moving the region")
+  {
+    auto a = pinned_vector<relative_node>(max_pages(16), 100);
+    link(a);
+    auto const b = a;
+    a.relocate_to_larger_reservation(max_pages(32));
+    CHECK(count_links(a.data()) == 100);
+    CHECK(count_links(b.data()) == 100);
+    auto const tail = a.split_off(50);
+    CHECK(tail.front().next.get() == &tail[1]);
+    CHECK(tail.back().next.get() == nullptr);
+  }
+}
@@ -0,0 +1,200 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "pinned_vector_test.hpp"
+
+#include "catch.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+using namespace mknejp::vmcontainer;
+using namespace vmcontainer_test;
+
+TEST_CASE("pinned_vector::relocate_to_larger_reservation() moves the pages into a new reservation",
+          "[pinned_vector][relocate]")
+{
+  struct tag
+  {};
+  auto alloc = tracking_allocator<tag>();
+  using traits = pinned_vector_test_traits<decltype(alloc)>;
+
+  char page1[2 * 4 * sizeof(int)];
+  char page2[4 * 4 * sizeof(int)];
+  alloc.set_page_size(4 * sizeof(int));
+  alloc.expect_reserve(page1, sizeof(page1));
+  alloc.expect_commit(page1, 2 * 4 * sizeof(int));
+
+  auto v = pinned_vector<int, traits>(max_pages(2), {1, 2, 3, 4, 5});
+  REQUIRE(v.capacity() == 8);
+
+  alloc.expect_reserve(page2, sizeof(page2));
+  alloc.expect_move_pages(page1, page2, 2 * 4 * sizeof(int));
+  alloc.expect_free(page1);
+  auto* const new_data = v.relocate_to_larger_reservation(max_pages(4));
+  CHECK(alloc.move_pages_calls() == 1);
+  CHECK(alloc.commit_calls() == 1);
+  CHECK(alloc.free_calls() == 1);
+  CHECK(new_data == reinterpret_cast<int*>(page2));
+  CHECK(v.data() == new_data);
+  CHECK(v.size() == 5);
+  CHECK(v.capacity() == 8);
+  CHECK(v.max_size() == 16);
+  CHECK(std::equal(v.begin(), v.end(), std::begin({1, 2, 3, 4, 5})));
+
+  alloc.expect_free(page2);
+}
+
+TEST_CASE("pinned_vector::relocate_to_larger_reservation() preserves the elements", "[pinned_vector][relocate]")
+{
+  auto v = pinned_vector<int>(max_pages(4));
+  auto const page_size = v.page_size();
+  v.resize(3 * page_size / sizeof(int) + 5);
+  std::iota(v.begin(), v.end(), 0);
+  auto const size = v.size();
+  auto const capacity = v.capacity();
+
+  auto* const old_data = v.data();
+  auto* const new_data = v.relocate_to_larger_reservation(max_pages(64));
+  CHECK(new_data != old_data);
+  CHECK(v.data() == new_data);
+  CHECK(v.size() == size);
+  CHECK(v.capacity() == capacity);
+  CHECK(v.max_size() == 64 * page_size / sizeof(int));
+  for(std::size_t i = 0; i < v.size(); ++i)
+  {
+    REQUIRE(v[i] == static_cast<int>(i));
+  }
+
+  // the tail of the new reservation can still be committed
+  v.resize(v.max_size(), 42);
+  CHECK(v[size - 1] == static_cast<int>(size - 1));
+  CHECK(v.back() == 42);
+}
+
+TEST_CASE("pinned_vector::split_off() remaps whole pages at a page aligned index", "[pinned_vector][relocate]")
+{
+  struct tag
+  {};
+  auto alloc = tracking_allocator<tag>();
+  using traits = pinned_vector_test_traits<decltype(alloc)>;
+
+  char page1[4 * 4 * sizeof(int)];
+  char page2[4 * 4 * sizeof(int)];
+  alloc.set_page_size(4 * sizeof(int));
+  alloc.expect_reserve(page1, sizeof(page1));
+  alloc.expect_commit(page1, 3 * 4 * sizeof(int));
+
+  auto v = pinned_vector<int, traits>(max_pages(4), {0, 1, 2, 3, 4, 5, 6, 7, 8, 9});
+  REQUIRE(v.capacity() == 12);
+
+  alloc.expect_reserve(page2, sizeof(page2));
+  alloc.expect_move_pages(page1 + 4 * sizeof(int), page2, 2 * 4 * sizeof(int));
+  {
+    auto tail = v.split_off(4);
+    CHECK(alloc.move_pages_calls() == 1);
+    CHECK(tail.data() == reinterpret_cast<int*>(page2));
+    CHECK(tail.max_size() == v.max_size());
+    CHECK(std::equal(tail.begin(), tail.end(), std::begin({4, 5, 6, 7, 8, 9})));
+    CHECK(v.capacity() == 4);
+    CHECK(std::equal(v.begin(), v.end(), std::begin({0, 1, 2, 3})));
+    alloc.expect_free(page2);
+  }
+  alloc.expect_free(page1);
+}
+
+TEST_CASE("pinned_vector::split_off() preserves the elements", "[pinned_vector][relocate]")
+{
+  auto v = pinned_vector<int>(max_pages(8));
+  auto const per_page = v.page_size() / sizeof(int);
+  v.resize(5 * per_page + 3);
+  std::iota(v.begin(), v.end(), 0);
+  auto const size = v.size();
+
+  auto test = [&](std::size_t index) {
+    CAPTURE(index);
+    auto w = v;
+    auto tail = w.split_off(index);
+    CHECK(tail.max_size() == w.max_size());
+    REQUIRE(w.size() == index);
+    REQUIRE(tail.size() == size - index);
+    CHECK(std::equal(w.begin(), w.end(), v.begin()));
+    CHECK(std::equal(tail.begin(), tail.end(), v.begin() + index));
+
+    // both halves keep working
+    w.push_back(-1);
+    tail.push_back(-2);
+    CHECK(w.back() == -1);
+    CHECK(tail.back() == -2);
+  };
+  test(0);
+  test(per_page);
+  test(2 * per_page + 1);
+  test(size - 1);
+  test(size);
+
+  SECTION("the pages behind an unaligned index are released")
+  {
+    auto w = v;
+    auto tail = w.split_off(2 * per_page + 1);
+    CHECK(w.capacity() == 3 * per_page);
+  }
+}
+
+TEST_CASE("pinned_vector::append_pages() moves the elements of another container", "[pinned_vector][relocate]")
+{
+  auto v = pinned_vector<int>(max_pages(16));
+  auto const per_page = v.page_size() / sizeof(int);
+
+  auto make_chunk = [](std::size_t count, int first) {
+    auto chunk = pinned_vector<int>(max_pages(4));
+    chunk.resize(count);
+    std::iota(chunk.begin(), chunk.end(), first);
+    return chunk;
+  };
+
+  SECTION("page aligned")
+  {
+    v.reserve(4 * per_page);
+    auto* const data = v.data();
+    v.append_pages(make_chunk(2 * per_page, 0));
+    v.append_pages(make_chunk(per_page + 1, static_cast<int>(2 * per_page)));
+    CHECK(v.data() == data);
+    REQUIRE(v.size() == 3 * per_page + 1);
+    for(std::size_t i = 0; i < v.size(); ++i)
+    {
+      REQUIRE(v[i] == static_cast<int>(i));
+    }
+  }
+  SECTION("not page aligned")
+  {
+    v.append_pages(make_chunk(3, 0));
+    v.append_pages(make_chunk(per_page, 3));
+    v.append_pages(make_chunk(0, 0));
+    REQUIRE(v.size() == per_page + 3);
+    for(std::size_t i = 0; i < v.size(); ++i)
+    {
+      REQUIRE(v[i] == static_cast<int>(i));
+    }
+  }
+  SECTION("an empty container keeps the spare capacity")
+  {
+    v.reserve(2 * per_page);
+    v.resize(per_page);
+    v.append_pages(make_chunk(0, 0));
+    CHECK(v.capacity() == 2 * per_page);
+  }
+  SECTION("leaves the other container empty")
+  {
+    auto chunk = make_chunk(per_page, 0);
+    auto const max_size = chunk.max_size();
+    v.append_pages(std::move(chunk));
+    CHECK(chunk.empty());
+    CHECK(chunk.max_size() == max_size);
+    chunk.push_back(5);
+    CHECK(chunk.front() == 5);
+  }
+}
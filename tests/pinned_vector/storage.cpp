@@ -0,0 +1,160 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "pinned_vector_test.hpp"
+
+#include "catch.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+using namespace mknejp::vmcontainer;
+using namespace vmcontainer_test;
+
+namespace
+{
+  struct record
+  {
+    std::uint32_t key;
+    std::uint32_t value;
+  };
+
+  // Counts the calls made through each instance into a shared counter.
+  struct counting_system : vm::system_default
+  {
+    counting_system() = default;
+    explicit counting_system(int* calls) noexcept : calls(calls) {}
+
+    auto reserve(std::size_t num_bytes) -> void*
+    {
+      ++*calls;
+      return system_default::reserve(num_bytes);
+    }
+    auto commit(void* offset, std::size_t num_bytes) -> void
+    {
+      ++*calls;
+      system_default::commit(offset, num_bytes);
+    }
+
+    int* calls = nullptr;
+  };
+
+  struct counting_traits
+  {
+    using storage_type = vm::page_stack_base<counting_system>;
+    using growth_factor = pinned_vector_traits::growth_factor;
+  };
+}
+
+static_assert(sizeof(pinned_vector<int>) == sizeof(void*) + 2 * sizeof(std::size_t) + sizeof(int*), "");
+
+static_assert(noexcept(std::declval<pinned_vector<int>&>().release_storage()), "");
+static_assert(!std::is_convertible<released_storage<vm::page_stack>, pinned_vector<int>>::value, "");
+
+TEST_CASE("pinned_vector::release_storage() transfers ownership of the storage", "[pinned_vector][storage]")
+{
+  auto v = pinned_vector<int>(max_pages(2), {1, 2, 3});
+  auto* const data = v.data();
+  auto const capacity = v.capacity();
+
+  auto released = v.release_storage();
+  CHECK(released.storage.base() == data);
+  CHECK(released.storage.committed_bytes() == capacity * sizeof(int));
+  CHECK(released.used_bytes == 3 * sizeof(int));
+
+  // left behind as if default constructed
+  CHECK(v.data() == nullptr);
+  CHECK(v.empty());
+  CHECK(v.capacity() == 0);
+  CHECK(v.max_size() == 0);
+}
+
+TEST_CASE("pinned_vector adopts storage with an initial element count", "[pinned_vector][storage]")
+{
+  auto storage = vm::page_stack(num_pages(1));
+  storage.resize(4 * sizeof(int));
+  auto* const p = static_cast<int*>(storage.base());
+  p[0] = 10;
+  p[1] = 11;
+
+  auto v = pinned_vector<int>(std::move(storage), 2);
+  CHECK(v.data() == p);
+  CHECK(v.size() == 2);
+  CHECK(v[0] == 10);
+  CHECK(v[1] == 11);
+  CHECK(v.max_size() == v.page_size() / sizeof(int));
+
+  v.push_back(12);
+  CHECK(v.size() == 3);
+  CHECK(v.data() == p);
+}
+
+TEST_CASE("pinned_vector reinterprets released bytes as another value_type without copying",
+          "[pinned_vector][storage]")
+{
+  auto bytes = pinned_vector<std::uint8_t>(max_pages(4));
+  for(std::uint32_t i = 0; i < 100; ++i)
+  {
+    auto const r = record{i, i * 2};
+    auto const* const first = reinterpret_cast<std::uint8_t const*>(&r);
+    bytes.insert(bytes.end(), first, first + sizeof(r));
+  }
+  auto* const data = bytes.data();
+
+  auto records = pinned_vector<record>(bytes.release_storage());
+  CHECK(bytes.empty());
+  CHECK(static_cast<void*>(records.data()) == data);
+  REQUIRE(records.size() == 100);
+  for(std::uint32_t i = 0; i < 100; ++i)
+  {
+    REQUIRE(records[i].key == i);
+    REQUIRE(records[i].value == i * 2);
+  }
+
+  records.push_back({100, 200});
+  CHECK(records.back().key == 100);
+  CHECK(records.max_size() == 4 * records.page_size() / sizeof(record));
+}
+
+TEST_CASE("pinned_vector routes storage calls through its virtual memory system", "[pinned_vector][storage]")
+{
+  auto calls_a = 0;
+  auto calls_b = 0;
+  auto a = pinned_vector<int, counting_traits>(max_pages(4), {1, 2, 3}, counting_system(&calls_a));
+  CHECK(a.vm_system().calls == &calls_a);
+  CHECK(calls_a == 2);
+
+  SECTION("for every constructor")
+  {
+    auto const values = {1, 2, 3};
+    auto b = pinned_vector<int, counting_traits>(max_pages(4), counting_system(&calls_b));
+    auto c = pinned_vector<int, counting_traits>(max_pages(4), values.begin(), values.end(), counting_system(&calls_b));
+    auto d = pinned_vector<int, counting_traits>(max_pages(4), 3, 7, counting_system(&calls_b));
+    auto e = pinned_vector<int, counting_traits>(max_pages(4), 3, counting_system(&calls_b));
+    CHECK(calls_b == 1 + 3 * 2);
+  }
+
+  SECTION("copies propagate the system")
+  {
+    auto b = a;
+    CHECK(b.vm_system().calls == &calls_a);
+    CHECK(calls_a == 4);
+    b.push_back(4);
+    CHECK(calls_a == 4);
+  }
+
+  SECTION("swap exchanges the systems")
+  {
+    auto b = pinned_vector<int, counting_traits>(max_pages(4), counting_system(&calls_b));
+    swap(a, b);
+    CHECK(a.vm_system().calls == &calls_b);
+    CHECK(b.vm_system().calls == &calls_a);
+    a.push_back(1);
+    CHECK(calls_b == 2);
+    CHECK(calls_a == 2);
+  }
+}
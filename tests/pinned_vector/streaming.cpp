@@ -0,0 +1,93 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "vmcontainer/pinned_vector.hpp"
+
+#include "catch.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+
+using namespace mknejp::vmcontainer;
+
+namespace
+{
+  // Does not tile a vector register, takes the regular path.
+  struct rgb
+  {
+    std::uint8_t r, g, b;
+  };
+  auto operator==(rgb const& a, rgb const& b) -> bool { return a.r == b.r && a.g == b.g && a.b == b.b; }
+}
+
+TEST_CASE("pinned_vector fills and copies above the streaming threshold", "[pinned_vector][streaming]")
+{
+  auto const count = VMCONTAINER_STREAMING_THRESHOLD / sizeof(std::uint64_t) + 5;
+  auto v = pinned_vector<std::uint64_t>(max_elements(count * 2));
+
+  SECTION("resize()")
+  {
+    v.push_back(1);
+    v.resize(count, 7);
+    CHECK(v.front() == 1);
+    CHECK(std::count(v.begin() + 1, v.end(), std::uint64_t(7)) == count - 1);
+    v.resize(1);
+    v.resize(count);
+    CHECK(std::count(v.begin() + 1, v.end(), std::uint64_t(0)) == count - 1);
+  }
+  SECTION("assign() and insert()")
+  {
+    v.assign(count, 3);
+    CHECK(v.size() == count);
+    CHECK(std::count(v.begin(), v.end(), std::uint64_t(3)) == count);
+    v.insert(v.begin(), count, 4);
+    CHECK(v.size() == count * 2);
+    CHECK(std::count(v.begin(), v.begin() + count, std::uint64_t(4)) == count);
+    CHECK(std::count(v.begin() + count, v.end(), std::uint64_t(3)) == count);
+  }
+  SECTION("copy constructor")
+  {
+    v.resize(count);
+    std::iota(v.begin(), v.end(), std::uint64_t(0));
+    auto const copy = v;
+    CHECK(std::equal(v.begin(), v.end(), copy.begin(), copy.end()));
+  }
+}
+
+TEST_CASE("pinned_vector fills types that do not tile a register", "[pinned_vector][streaming]")
+{
+  auto const count = VMCONTAINER_STREAMING_THRESHOLD / sizeof(rgb) + 5;
+  auto v = pinned_vector<rgb>(max_elements(count));
+  v.resize(count, rgb{1, 2, 3});
+  CHECK(std::all_of(v.begin(), v.end(), [](rgb const& x) { return x == rgb{1, 2, 3}; }));
+  v.assign(v.size(), rgb{4, 5, 6});
+  CHECK(std::all_of(v.begin(), v.end(), [](rgb const& x) { return x == rgb{4, 5, 6}; }));
+}
+
+TEST_CASE("pinned_vector does not value-initialize pages the system committed zeroed", "[pinned_vector][streaming]")
+{
+  auto v = pinned_vector<std::uint64_t>(max_pages(16));
+  auto const per_page = v.page_size() / sizeof(std::uint64_t);
+
+  v.resize(4 * per_page);
+  CHECK(v.residency().touched_pages == 0);
+  CHECK(std::all_of(v.begin(), v.end(), [](std::uint64_t x) { return x == 0; }));
+
+  SECTION("elements in pages committed before are written")
+  {
+    std::fill(v.begin(), v.end(), std::uint64_t(9));
+    while(v.size() > 1)
+    {
+      v.pop_back();
+    }
+    REQUIRE(v.capacity() == 4 * per_page);
+    v.resize(6 * per_page);
+    CHECK(v.residency(4 * per_page, 2 * per_page).touched_pages == 0);
+    CHECK(v.front() == 9);
+    CHECK(std::all_of(v.begin() + 1, v.end(), [](std::uint64_t x) { return x == 0; }));
+  }
+}
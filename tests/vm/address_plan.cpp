@@ -0,0 +1,59 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "vmcontainer/address_plan.hpp"
+
+#include "catch.hpp"
+
+#include <stdexcept>
+#include <system_error>
+
+using namespace mknejp::vmcontainer;
+
+TEST_CASE("vm::address_plan", "[address_plan]")
+{
+  auto const page_size = vm::system_default::page_size();
+  auto& plan = vm::address_plan::instance();
+  plan.clear();
+
+  // Find some free address space to hand out.
+  auto* const address = static_cast<char*>(vm::reservation(num_pages(8)).base());
+  plan.assign("a", address, 4 * page_size);
+  plan.assign("b", address + 4 * page_size, 3 * page_size + 1);
+
+  SECTION("find() returns the assigned ranges")
+  {
+    CHECK(plan.find("a").base == address);
+    CHECK(plan.find("a").num_bytes == 4 * page_size);
+    CHECK(plan.find("b").base == address + 4 * page_size);
+    CHECK(plan.find("b").num_bytes == 4 * page_size);
+    CHECK(plan.find("c").base == nullptr);
+    CHECK(plan.find("c").num_bytes == 0);
+  }
+
+  SECTION("assign() rejects invalid ranges")
+  {
+    CHECK_THROWS_AS(plan.assign("a", address + 8 * page_size, page_size), std::invalid_argument);
+    CHECK_THROWS_AS(plan.assign("c", address + 3 * page_size, page_size), std::invalid_argument);
+    CHECK_THROWS_AS(plan.assign("c", address + 8 * page_size + 1, page_size), std::invalid_argument);
+    CHECK_THROWS_AS(plan.assign("c", address + 8 * page_size, 0), std::invalid_argument);
+    CHECK_NOTHROW(plan.assign("c", address + 8 * page_size, page_size));
+  }
+
+  SECTION("reserve() reserves at the assigned address")
+  {
+    auto a = plan.reserve("a");
+    CHECK(a.base() == address);
+    CHECK(a.reserved_bytes() == 4 * page_size);
+    CHECK_THROWS_AS(plan.reserve("c"), std::out_of_range);
+
+    plan.remove("a");
+    plan.assign("c", address + 2 * page_size, page_size);
+    CHECK_THROWS_AS(plan.reserve("c"), std::system_error);
+  }
+
+  plan.clear();
+}
@@ -0,0 +1,127 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "vmcontainer/budget.hpp"
+#include "vmcontainer/pinned_vector.hpp"
+
+#include "catch.hpp"
+
+#include <new>
+#include <vector>
+
+using namespace mknejp::vmcontainer;
+
+static_assert(sizeof(vm::reservation_base<vm::budgeted_system<>>) == sizeof(vm::reservation) + sizeof(void*), "");
+
+namespace
+{
+  struct budgeted_traits
+  {
+    using storage_type = vm::page_stack_base<vm::budgeted_system<>>;
+    using growth_factor = pinned_vector_traits::growth_factor;
+  };
+}
+
+TEST_CASE("vm::memory_budget", "[memory_budget]")
+{
+  vm::memory_budget parent(1000, nullptr);
+  vm::memory_budget child(600, &parent);
+  CHECK(child.parent() == &parent);
+  CHECK(vm::memory_budget().parent() == &vm::memory_budget::global());
+
+  SECTION("charges propagate to the parent")
+  {
+    CHECK(child.try_charge(500));
+    CHECK(child.committed_bytes() == 500);
+    CHECK(parent.committed_bytes() == 500);
+    child.uncharge(200);
+    CHECK(child.committed_bytes() == 300);
+    CHECK(parent.committed_bytes() == 300);
+  }
+
+  SECTION("charges beyond any hard limit fail without side effects")
+  {
+    CHECK(!child.try_charge(601));
+    CHECK(child.committed_bytes() == 0);
+    CHECK(parent.try_charge(500));
+    CHECK(!child.try_charge(501));
+    CHECK(child.committed_bytes() == 0);
+    CHECK(parent.committed_bytes() == 500);
+    CHECK(child.try_charge(500));
+    CHECK(parent.committed_bytes() == 1000);
+  }
+
+  SECTION("soft limit callbacks fire when the watermark is crossed")
+  {
+    auto crossings = std::vector<std::size_t>();
+    child.set_soft_limit(300, [&](vm::memory_budget& budget, std::size_t committed_bytes) {
+      CHECK(&budget == &child);
+      crossings.push_back(committed_bytes);
+    });
+    CHECK(child.try_charge(200));
+    CHECK(child.try_charge(150));
+    CHECK(child.try_charge(100));
+    CHECK(crossings == std::vector<std::size_t>{350});
+    child.uncharge(400);
+    CHECK(child.try_charge(300));
+    CHECK(crossings == std::vector<std::size_t>{350, 350});
+  }
+
+  SECTION("uncharging saturates at zero")
+  {
+    CHECK(child.try_charge(100));
+    child.uncharge(200);
+    CHECK(child.committed_bytes() == 0);
+    CHECK(parent.committed_bytes() == 0);
+  }
+}
+
+TEST_CASE("pinned_vector with budgeted_system", "[memory_budget][pinned_vector]")
+{
+  auto const page_size = vm::system_default::page_size();
+  vm::memory_budget budget(4 * page_size);
+  auto const global_bytes = vm::memory_budget::global().committed_bytes();
+  {
+    auto v = pinned_vector<char, budgeted_traits>(max_pages(16), vm::budgeted_system<>(budget));
+    v.resize(3 * page_size);
+    CHECK(budget.committed_bytes() == 3 * page_size);
+    CHECK(vm::memory_budget::global().committed_bytes() == global_bytes + 3 * page_size);
+
+    CHECK_THROWS_AS(v.resize(5 * page_size), std::bad_alloc);
+    CHECK(v.size() == 3 * page_size);
+    CHECK(budget.committed_bytes() == 3 * page_size);
+
+    v.resize(page_size);
+    v.shrink_to_fit();
+    CHECK(budget.committed_bytes() == page_size);
+
+    auto w = v;
+    CHECK(budget.committed_bytes() == 2 * page_size);
+    w = pinned_vector<char, budgeted_traits>();
+    CHECK(budget.committed_bytes() == page_size);
+  }
+  CHECK(budget.committed_bytes() == 0);
+  CHECK(vm::memory_budget::global().committed_bytes() == global_bytes);
+}
+
+TEST_CASE("pages moved between budgets change their charge", "[memory_budget][pinned_vector]")
+{
+  auto const page_size = vm::system_default::page_size();
+  vm::memory_budget a(4 * page_size);
+  vm::memory_budget b(2 * page_size);
+  auto v = pinned_vector<char, budgeted_traits>(max_pages(16), vm::budgeted_system<>(a));
+  auto w = pinned_vector<char, budgeted_traits>(max_pages(16), vm::budgeted_system<>(b));
+  v.resize(3 * page_size);
+  CHECK_THROWS_AS(w.append_pages(std::move(v)), std::bad_alloc);
+  CHECK(a.committed_bytes() == 3 * page_size);
+  CHECK(b.committed_bytes() == 0);
+
+  v.resize(2 * page_size);
+  w.append_pages(std::move(v));
+  CHECK(w.size() == 2 * page_size);
+  CHECK(a.committed_bytes() == 0);
+  CHECK(b.committed_bytes() == 2 * page_size);
+}
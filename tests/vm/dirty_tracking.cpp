@@ -0,0 +1,183 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "vmcontainer/dirty_tracking.hpp"
+#include "vmcontainer/pinned_vector.hpp"
+
+#include "catch.hpp"
+
+#include <csignal>
+#include <cstddef>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace mknejp::vmcontainer;
+
+namespace
+{
+  struct tracked_traits
+  {
+    using storage_type = vm::page_stack_base<vm::dirty_tracking_system<>>;
+    using growth_factor = pinned_vector_traits::growth_factor;
+  };
+
+  using vector = pinned_vector<char, tracked_traits>;
+
+  auto write_page(vector& v, std::size_t page) -> void { v[page * vm::system_default::page_size() + 1] += 1; }
+
+  // Run f in a child process and return the signal that terminated it, or 0. Catch installs its own handler, the child
+  // starts from the default action instead so trackers created by f pass unhandled faults on to it.
+  template<typename F>
+  auto signal_in_child(F f) -> int
+  {
+    auto const child = ::fork();
+    REQUIRE(child >= 0);
+    if(child == 0)
+    {
+      std::signal(SIGSEGV, SIG_DFL);
+      f();
+      ::_exit(0);
+    }
+    auto status = 0;
+    REQUIRE(::waitpid(child, &status, 0) == child);
+    return WIFSIGNALED(status) ? WTERMSIG(status) : 0;
+  }
+}
+
+TEST_CASE("dirty_page_tracker records the pages written in each epoch", "[dirty_page_tracker]")
+{
+  auto const page_size = vm::system_default::page_size();
+  auto v = vector(max_pages(64), page_size * 16);
+  auto& tracker = v.vm_system().tracker();
+  REQUIRE(tracker.committed_bytes() == page_size * 16);
+  CHECK(tracker.current_epoch() == 1);
+  CHECK(tracker.dirty_pages_since(1).size() == 16);
+
+  auto const first = tracker.advance_epoch();
+  CHECK(first == 2);
+  CHECK(tracker.dirty_pages_since(first).empty());
+
+  write_page(v, 3);
+  write_page(v, 11);
+  write_page(v, 3);
+  CHECK(tracker.dirty_pages_since(first) == std::vector<std::size_t>{3, 11});
+
+  auto const second = tracker.advance_epoch();
+  CHECK(tracker.dirty_pages_since(second).empty());
+  write_page(v, 7);
+  CHECK(tracker.dirty_pages_since(second) == std::vector<std::size_t>{7});
+  CHECK(tracker.dirty_pages_since(first) == std::vector<std::size_t>{3, 7, 11});
+
+  // Reading does not dirty a page.
+  auto sum = 0;
+  for(auto c : v)
+  {
+    sum += c;
+  }
+  CHECK(sum == 4);
+  CHECK(tracker.dirty_pages_since(tracker.advance_epoch()).empty());
+}
+
+TEST_CASE("dirty_page_tracker treats committed pages as dirty", "[dirty_page_tracker]")
+{
+  auto const page_size = vm::system_default::page_size();
+  auto v = vector(max_pages(64), page_size * 4);
+  auto& tracker = v.vm_system().tracker();
+  auto const epoch = tracker.advance_epoch();
+
+  v.resize(page_size * 6);
+  CHECK(tracker.dirty_pages_since(epoch) == std::vector<std::size_t>{4, 5});
+
+  v.resize(page_size * 2);
+  CHECK(tracker.committed_bytes() == page_size * 2);
+  CHECK(tracker.dirty_pages_since(1) == std::vector<std::size_t>{0, 1});
+}
+
+TEST_CASE("dirty_page_tracker tracks pages appended from another vector", "[dirty_page_tracker]")
+{
+  auto const page_size = vm::system_default::page_size();
+  auto v = vector(max_pages(64), page_size * 4);
+  auto& tracker = v.vm_system().tracker();
+  tracker.advance_epoch();
+  auto const epoch = tracker.advance_epoch();
+
+  auto tail = v.split_off(page_size * 2);
+  CHECK(tracker.committed_bytes() == page_size * 2);
+  // The moved pages are write-protected by the source tracker and must be writable in their new home.
+  auto& tail_tracker = tail.vm_system().tracker();
+  auto const tail_epoch = tail_tracker.advance_epoch();
+  write_page(tail, 1);
+  CHECK(tail_tracker.dirty_pages_since(tail_epoch) == std::vector<std::size_t>{1});
+  CHECK(tracker.dirty_pages_since(epoch).empty());
+}
+
+TEST_CASE("dirty_tracking_system extends reservations together with the tracker", "[dirty_page_tracker]")
+{
+  auto const page_size = vm::system_default::page_size();
+  // Leave room behind the reservation.
+  auto* const address = vm::reservation(num_pages(8192)).base();
+  auto stack = vm::page_stack_base<vm::dirty_tracking_system<>>(address, num_pages(4));
+  auto& tracker = stack.vm_system().tracker();
+  stack.resize(page_size * 4);
+  // Enough pages that the stamps need more than one page of their own.
+  REQUIRE(stack.try_extend(num_pages(4096)));
+  CHECK(stack.reserved_bytes() == page_size * 4096);
+
+  stack.resize(page_size * 2000);
+  auto const epoch = tracker.advance_epoch();
+  auto* const p = static_cast<char*>(stack.base());
+  p[page_size * 2] = 1;
+  p[page_size * 1999] = 1;
+  CHECK(tracker.committed_bytes() == page_size * 2000);
+  CHECK(tracker.dirty_pages_since(epoch) == std::vector<std::size_t>{2, 1999});
+}
+
+TEST_CASE("dirty_tracking_system storage can be frozen", "[dirty_page_tracker]")
+{
+  auto const page_size = vm::system_default::page_size();
+  // Neither the page written in this epoch nor the protected ones may become writable.
+  auto const write_frozen = [&](std::size_t page) {
+    return signal_in_child([&] {
+      auto v = vector(max_pages(64), page_size * 4);
+      v.vm_system().tracker().advance_epoch();
+      write_page(v, 0);
+      v.freeze();
+      write_page(v, page);
+    });
+  };
+  CHECK(write_frozen(0) == SIGSEGV);
+  CHECK(write_frozen(1) == SIGSEGV);
+
+  auto v = vector(max_pages(64), page_size * 4);
+  auto& tracker = v.vm_system().tracker();
+  auto const epoch = tracker.advance_epoch();
+  write_page(v, 0);
+  v.freeze();
+  CHECK(tracker.dirty_pages_since(epoch) == std::vector<std::size_t>{0});
+  v.thaw();
+  CHECK(tracker.dirty_pages_since(epoch) == std::vector<std::size_t>{0});
+  write_page(v, 2);
+  CHECK(tracker.dirty_pages_since(epoch) == std::vector<std::size_t>{0, 2});
+}
+
+TEST_CASE("dirty_page_tracker passes other faults on", "[dirty_page_tracker]")
+{
+  auto const page_size = vm::system_default::page_size();
+  auto const sig = signal_in_child([&] {
+    auto v = vector(max_pages(64), page_size);
+    v.vm_system().tracker().advance_epoch();
+    write_page(v, 0);
+    if(v.vm_system().tracker().dirty_pages_since(2).size() != 1)
+    {
+      ::_exit(1);
+    }
+    // Beyond the committed pages.
+    v.data()[page_size * 2] = 1;
+  });
+  CHECK(sig == SIGSEGV);
+}
@@ -0,0 +1,106 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "vmcontainer/dump_policy.hpp"
+#include "vmcontainer/pinned_vector.hpp"
+
+#include "catch.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+using namespace mknejp::vmcontainer;
+
+#ifdef __linux__
+
+namespace
+{
+  struct dump_traits
+  {
+    using storage_type = vm::page_stack_base<vm::dump_policy_system<>>;
+    using growth_factor = pinned_vector_traits::growth_factor;
+  };
+
+  using vector = pinned_vector<char, dump_traits>;
+
+  // Whether the mapping containing p lacks the "dd" (do not dump) flag in /proc/self/smaps.
+  auto is_dumpable(void const* p) -> bool
+  {
+    auto* const file = std::fopen("/proc/self/smaps", "re");
+    REQUIRE(file != nullptr);
+    auto const address = reinterpret_cast<std::uintptr_t>(p);
+    auto found = false;
+    auto dumpable = true;
+    char line[512];
+    while(std::fgets(line, sizeof(line), file))
+    {
+      unsigned long long start = 0;
+      unsigned long long end = 0;
+      if(std::sscanf(line, "%llx-%llx ", &start, &end) == 2)
+      {
+        found = start <= address && address < end;
+      }
+      else if(found && std::strncmp(line, "VmFlags:", 8) == 0)
+      {
+        dumpable = std::strstr(line, " dd") == nullptr;
+        break;
+      }
+    }
+    std::fclose(file);
+    return dumpable;
+  }
+}
+
+TEST_CASE("vm::dump_policy_system", "[dump_policy_system]")
+{
+  auto const page_size = vm::system_default::page_size();
+
+  SECTION("excludes everything by default")
+  {
+    auto v = vector(max_pages(4), 4 * page_size);
+    CHECK(!is_dumpable(v.data()));
+    CHECK(!is_dumpable(v.data() + 3 * page_size));
+  }
+
+  SECTION("dump_policy::all() includes everything")
+  {
+    auto v = vector(max_pages(4), 4 * page_size, vm::dump_policy_system<>(vm::dump_policy::all()));
+    CHECK(is_dumpable(v.data()));
+    CHECK(is_dumpable(v.data() + 3 * page_size));
+  }
+
+  SECTION("dump_policy::first() includes the first pages")
+  {
+    auto v = vector(max_pages(4), 4 * page_size, vm::dump_policy_system<>(vm::dump_policy::first(page_size + 1)));
+    CHECK(is_dumpable(v.data()));
+    CHECK(is_dumpable(v.data() + page_size));
+    CHECK(!is_dumpable(v.data() + 2 * page_size));
+    CHECK(!is_dumpable(v.data() + 3 * page_size));
+
+    SECTION("copies keep the policy")
+    {
+      auto const w = v;
+      CHECK(is_dumpable(w.data() + page_size));
+      CHECK(!is_dumpable(w.data() + 2 * page_size));
+    }
+  }
+
+  SECTION("relocated pages take the policy of their new reservation")
+  {
+    auto v = vector(max_pages(4), 4 * page_size);
+    auto w = vector(max_pages(8), vm::dump_policy_system<>(vm::dump_policy::first(6 * page_size)));
+    w.resize(4 * page_size);
+    w.append_pages(std::move(v));
+    REQUIRE(w.size() == 8 * page_size);
+    CHECK(is_dumpable(w.data() + 4 * page_size));
+    CHECK(is_dumpable(w.data() + 5 * page_size));
+    CHECK(!is_dumpable(w.data() + 6 * page_size));
+    CHECK(!is_dumpable(w.data() + 7 * page_size));
+  }
+}
+
+#endif
@@ -0,0 +1,469 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "vmcontainer/file_storage.hpp"
+#include "vmcontainer/pinned_vector.hpp"
+
+#include "catch.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+#ifdef __linux__
+#  include <sys/socket.h>
+#  include <sys/wait.h>
+#  include <unistd.h>
+#endif
+
+using namespace mknejp::vmcontainer;
+
+static_assert(std::is_nothrow_default_constructible<vm::memfd_page_stack>::value, "");
+static_assert(std::is_nothrow_move_constructible<vm::memfd_page_stack>::value, "");
+static_assert(std::is_nothrow_move_assignable<vm::memfd_page_stack>::value, "");
+static_assert(std::is_nothrow_move_constructible<vm::memfd_snapshot>::value, "");
+
+static_assert(std::is_nothrow_default_constructible<vm::file_page_stack>::value, "");
+static_assert(std::is_nothrow_move_constructible<vm::file_page_stack>::value, "");
+static_assert(std::is_nothrow_move_assignable<vm::file_page_stack>::value, "");
+
+static_assert(std::is_nothrow_default_constructible<vm::shared_page_stack>::value, "");
+static_assert(std::is_nothrow_move_constructible<vm::shared_page_stack>::value, "");
+static_assert(std::is_nothrow_move_assignable<vm::shared_page_stack>::value, "");
+static_assert(std::is_nothrow_move_constructible<vm::shared_page_view>::value, "");
+
+#ifdef __linux__
+
+namespace
+{
+  struct memfd_traits
+  {
+    using storage_type = vm::memfd_page_stack;
+    using growth_factor = pinned_vector_traits::growth_factor;
+  };
+
+  struct file_traits
+  {
+    using storage_type = vm::file_page_stack;
+    using growth_factor = pinned_vector_traits::growth_factor;
+  };
+
+  struct shared_traits
+  {
+    using storage_type = vm::shared_page_stack;
+    using growth_factor = pinned_vector_traits::growth_factor;
+  };
+
+  auto read_file(int fd, std::size_t num_bytes, std::size_t offset = 0) -> std::vector<char>
+  {
+    auto result = std::vector<char>(num_bytes);
+    REQUIRE(::pread(fd, result.data(), num_bytes, static_cast<off_t>(offset)) == static_cast<ssize_t>(num_bytes));
+    return result;
+  }
+
+  // Unique path of a file that is deleted when going out of scope.
+  class temp_file
+  {
+  public:
+    temp_file()
+    {
+      auto const fd = ::mkstemp(_path);
+      REQUIRE(fd >= 0);
+      ::close(fd);
+      ::unlink(_path);
+    }
+    temp_file(temp_file const&) = delete;
+    auto operator=(temp_file const&) -> temp_file& = delete;
+    ~temp_file() { ::unlink(_path); }
+
+    auto path() const noexcept -> char const* { return _path; }
+
+  private:
+    char _path[32] = "/tmp/vmcontainer.test.XXXXXX";
+  };
+}
+
+TEST_CASE("vm::memfd_page_stack", "[memfd_page_stack]")
+{
+  auto const page_size = vm::system_default::page_size();
+
+  SECTION("default constructed has no reservation")
+  {
+    auto vmps = vm::memfd_page_stack();
+    CHECK(vmps.base() == nullptr);
+    CHECK(vmps.reserved_bytes() == 0);
+    CHECK(vmps.committed_bytes() == 0);
+    CHECK(vmps.fd() == -1);
+  }
+
+  SECTION("committed pages live in the file")
+  {
+    auto vmps = vm::memfd_page_stack(num_pages(4));
+    REQUIRE(vmps.base() != nullptr);
+    CHECK(vmps.reserved_bytes() == 4 * page_size);
+    REQUIRE(vmps.fd() >= 0);
+
+    CHECK(vmps.resize(1) == page_size);
+    CHECK(vmps.resize(2 * page_size + 1) == 3 * page_size);
+    auto* const p = static_cast<char*>(vmps.base());
+    std::fill_n(p, 3 * page_size, 'x');
+    auto const contents = read_file(vmps.fd(), 3 * page_size);
+    CHECK(std::all_of(contents.begin(), contents.end(), [](char c) { return c == 'x'; }));
+
+    CHECK(vmps.resize(page_size) == page_size);
+    CHECK(::lseek(vmps.fd(), 0, SEEK_END) == static_cast<off_t>(page_size));
+
+    // recommitted pages are zeroed
+    vmps.resize(2 * page_size);
+    CHECK(p[page_size] == 0);
+  }
+
+  SECTION("snapshots are not affected by later writes")
+  {
+    auto vmps = vm::memfd_page_stack(num_pages(8));
+    vmps.resize(2 * page_size);
+    auto* const p = static_cast<char*>(vmps.base());
+    std::fill_n(p, 2 * page_size, 'a');
+    auto const fd = vmps.fd();
+
+    auto s1 = vmps.snapshot();
+    REQUIRE(s1.mapped_bytes() == 2 * page_size);
+    auto const* const q1 = static_cast<char const*>(s1.base());
+    CHECK(q1 != p);
+
+    p[0] = 'b';
+    vmps.resize(4 * page_size);
+    p[3 * page_size] = 'c';
+    CHECK(q1[0] == 'a');
+    CHECK(q1[page_size] == 'a');
+
+    // s1 is still alive so the next snapshot must not touch its file
+    auto s2 = vmps.snapshot();
+    REQUIRE(s2.mapped_bytes() == 4 * page_size);
+    auto const* const q2 = static_cast<char const*>(s2.base());
+    p[page_size] = 'd';
+    CHECK(q1[0] == 'a');
+    CHECK(q1[page_size] == 'a');
+    CHECK(q2[0] == 'b');
+    CHECK(q2[page_size] == 'a');
+    CHECK(q2[3 * page_size] == 'c');
+    CHECK(p[0] == 'b');
+    CHECK(p[page_size] == 'd');
+    CHECK(p[3 * page_size] == 'c');
+    // Only the modified pages were copied, the file is still the same.
+    CHECK(vmps.fd() == fd);
+
+    // Once all snapshots are gone the modified pages go back into the file.
+    s1 = {};
+    s2 = {};
+    auto s3 = vmps.snapshot();
+    CHECK(vmps.fd() == fd);
+    CHECK(std::equal(p, p + 4 * page_size, static_cast<char const*>(s3.base())));
+  }
+
+  SECTION("modified pages are written back once no snapshot refers to the file")
+  {
+    auto vmps = vm::memfd_page_stack(num_pages(8));
+    vmps.resize(4 * page_size);
+    auto* const p = static_cast<char*>(vmps.base());
+    std::fill_n(p, 4 * page_size, 'a');
+    auto const fd = vmps.fd();
+
+    {
+      auto s = vmps.snapshot();
+    }
+    p[page_size] = 'b';
+    vmps.resize(page_size);
+    vmps.resize(3 * page_size);
+    p[2 * page_size] = 'c';
+
+    auto s = vmps.snapshot();
+    CHECK(vmps.fd() == fd);
+    auto const* const q = static_cast<char const*>(s.base());
+    REQUIRE(s.mapped_bytes() == 3 * page_size);
+    CHECK(q[0] == 'a');
+    CHECK(q[page_size] == 0);
+    CHECK(q[2 * page_size] == 'c');
+    CHECK(q[2 * page_size + 1] == 0);
+    CHECK(std::equal(q, q + 3 * page_size, p));
+  }
+}
+
+TEST_CASE("pinned_vector::snapshot() captures the elements", "[memfd_page_stack][pinned_vector]")
+{
+  auto v = pinned_vector<int, memfd_traits>(max_elements(100000));
+  v.resize(50000);
+  std::iota(v.begin(), v.end(), 0);
+
+  auto s = v.snapshot();
+  static_assert(std::is_same<decltype(s), pinned_snapshot<int, vm::memfd_snapshot>>::value, "");
+  REQUIRE(s.size() == 50000);
+  CHECK(s.data() != v.data());
+
+  std::fill(v.begin(), v.end(), -1);
+  v.resize(100000, -2);
+  v.clear();
+  v.shrink_to_fit();
+
+  for(std::size_t i = 0; i < s.size(); ++i)
+  {
+    REQUIRE(s[i] == static_cast<int>(i));
+  }
+  CHECK(s.front() == 0);
+  CHECK(s.back() == 49999);
+
+  v.push_back(7);
+  auto s2 = v.snapshot();
+  REQUIRE(s2.size() == 1);
+  CHECK(s2[0] == 7);
+  CHECK(s[0] == 0);
+}
+
+TEST_CASE("vm::file_page_stack", "[file_page_stack]")
+{
+  auto const page_size = vm::system_default::page_size();
+  temp_file const file;
+
+  SECTION("default constructed has no reservation")
+  {
+    auto vmps = vm::file_page_stack();
+    CHECK(vmps.base() == nullptr);
+    CHECK(vmps.reserved_bytes() == 0);
+    CHECK(vmps.committed_bytes() == 0);
+    CHECK(vmps.fd() == -1);
+  }
+
+  SECTION("a new file only contains the header")
+  {
+    auto vmps = vm::file_page_stack(file.path(), num_pages(4));
+    CHECK(vmps.reserved_bytes() == 4 * page_size);
+    CHECK(vmps.committed_bytes() == 0);
+    CHECK(vmps.used_bytes() == 0);
+    CHECK(::lseek(vmps.fd(), 0, SEEK_END) == static_cast<off_t>(vm::file_page_stack::header_bytes));
+  }
+
+  SECTION("committed pages live in the file after the header")
+  {
+    auto vmps = vm::file_page_stack(file.path(), num_pages(4));
+    CHECK(vmps.resize(2 * page_size) == 2 * page_size);
+    auto* const p = static_cast<char*>(vmps.base());
+    std::fill_n(p, 2 * page_size, 'x');
+    vmps.flush(0, 2 * page_size);
+    auto const contents = read_file(vmps.fd(), 2 * page_size, vm::file_page_stack::header_bytes);
+    CHECK(std::all_of(contents.begin(), contents.end(), [](char c) { return c == 'x'; }));
+
+    CHECK(vmps.resize(page_size) == page_size);
+    CHECK(::lseek(vmps.fd(), 0, SEEK_END) == static_cast<off_t>(vm::file_page_stack::header_bytes + page_size));
+  }
+
+  SECTION("contents and used bytes survive reopening")
+  {
+    {
+      auto vmps = vm::file_page_stack(file.path(), num_pages(4));
+      vmps.resize(3 * page_size);
+      auto* const p = static_cast<char*>(vmps.base());
+      std::fill_n(p, 3 * page_size, 'y');
+      vmps.flush(2 * page_size + 5);
+      CHECK(vmps.used_bytes() == 2 * page_size + 5);
+    }
+    auto vmps = vm::file_page_stack(file.path(), num_pages(8));
+    CHECK(vmps.reserved_bytes() == 8 * page_size);
+    CHECK(vmps.committed_bytes() == 3 * page_size);
+    CHECK(vmps.used_bytes() == 2 * page_size + 5);
+    auto const* const p = static_cast<char const*>(vmps.base());
+    CHECK(std::all_of(p, p + 3 * page_size, [](char c) { return c == 'y'; }));
+  }
+
+  SECTION("reopening with a smaller reservation keeps all of the file")
+  {
+    {
+      auto vmps = vm::file_page_stack(file.path(), num_pages(4));
+      vmps.resize(3 * page_size);
+    }
+    auto vmps = vm::file_page_stack(file.path(), num_pages(1));
+    CHECK(vmps.reserved_bytes() == 3 * page_size);
+    CHECK(vmps.committed_bytes() == 3 * page_size);
+  }
+
+  SECTION("foreign files are rejected")
+  {
+    {
+      auto vmps = vm::file_page_stack(file.path(), num_pages(1));
+      auto const garbage = "garbage";
+      REQUIRE(::pwrite(vmps.fd(), garbage, 7, 0) == 7);
+    }
+    CHECK_THROWS_AS(vm::file_page_stack(file.path(), num_pages(1)), std::system_error);
+  }
+}
+
+TEST_CASE("pinned_vector with file_page_stack survives reopening", "[file_page_stack][pinned_vector]")
+{
+  temp_file const file;
+  {
+    auto v = pinned_vector<int, file_traits>(vm::file_page_stack(file.path(), num_pages(64)), 0);
+    v.resize(10000);
+    std::iota(v.begin(), v.end(), 0);
+    v.flush();
+    // not flushed, so not part of the persisted size
+    v.push_back(-1);
+  }
+
+  auto storage = vm::file_page_stack(file.path(), num_pages(64));
+  auto const count = storage.used_bytes() / sizeof(int);
+  auto v = pinned_vector<int, file_traits>(std::move(storage), count);
+  REQUIRE(v.size() == 10000);
+  for(std::size_t i = 0; i < v.size(); ++i)
+  {
+    REQUIRE(v[i] == static_cast<int>(i));
+  }
+  v.push_back(10000);
+  CHECK(v.back() == 10000);
+}
+
+TEST_CASE("pinned_vector with file_page_stack at a fixed address keeps pointers", "[file_page_stack][pinned_vector]")
+{
+  struct node
+  {
+    int value;
+    node const* next;
+  };
+
+  temp_file const file;
+  // Find some free address space for the file.
+  auto* const address = vm::reservation(num_pages(64)).base();
+  {
+    auto v = pinned_vector<node, file_traits>(vm::file_page_stack(file.path(), address, num_pages(64)), 0);
+    REQUIRE(v.data() == address);
+    v.resize(1000);
+    for(std::size_t i = 0; i < v.size(); ++i)
+    {
+      v[i] = {static_cast<int>(i), i + 1 < v.size() ? &v[i + 1] : nullptr};
+    }
+    v.flush();
+  }
+
+  auto storage = vm::file_page_stack(file.path(), address, num_pages(64));
+  REQUIRE(storage.base() == address);
+  auto const count = storage.used_bytes() / sizeof(node);
+  auto v = pinned_vector<node, file_traits>(std::move(storage), count);
+  auto expected = 0;
+  for(auto const* p = v.data(); p != nullptr; p = p->next)
+  {
+    REQUIRE(p->value == expected++);
+  }
+  CHECK(expected == 1000);
+
+  CHECK_THROWS_AS(vm::file_page_stack(file.path(), address, num_pages(64)), std::system_error);
+}
+
+TEST_CASE("vm::shared_page_view follows a vm::shared_page_stack", "[shared_page_stack]")
+{
+  auto const page_size = vm::system_default::page_size();
+  auto stack = vm::shared_page_stack(num_pages(16));
+  REQUIRE(stack.base() != nullptr);
+  REQUIRE(stack.reserved_bytes() == 16 * page_size);
+
+  auto view = vm::shared_page_view(vm::file_descriptor(::dup(stack.fd())));
+  CHECK(view.reserved_bytes() == stack.reserved_bytes());
+  CHECK(view.update() == 0);
+  CHECK(view.mapped_bytes() == 0);
+
+  stack.resize(2 * page_size);
+  std::memset(stack.base(), 'a', 2 * page_size);
+  CHECK(view.update() == 0);
+  CHECK(view.mapped_bytes() == 2 * page_size);
+
+  stack.flush(page_size + 10);
+  CHECK(view.update() == page_size + 10);
+  auto const* const p = static_cast<char const*>(view.base());
+  CHECK(std::all_of(p, p + 2 * page_size, [](char c) { return c == 'a'; }));
+
+  SECTION("shrinking keeps the pages mapped by readers accessible")
+  {
+    stack.flush(0);
+    stack.resize(page_size);
+    CHECK(view.update() == 0);
+    CHECK(p[page_size] == 0);
+    stack.resize(4 * page_size);
+    std::memset(static_cast<char*>(stack.base()) + page_size, 'b', 3 * page_size);
+    stack.flush(4 * page_size);
+    CHECK(view.update() == 4 * page_size);
+    CHECK(view.mapped_bytes() == 4 * page_size);
+    CHECK(p[0] == 'a');
+    CHECK(std::all_of(p + page_size, p + 4 * page_size, [](char c) { return c == 'b'; }));
+  }
+}
+
+TEST_CASE("pinned_vector with shared_page_stack is readable from another process", "[shared_page_stack][pinned_vector]")
+{
+  int sockets[2];
+  REQUIRE(::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) == 0);
+  auto const count = 100000;
+
+  auto const child = ::fork();
+  REQUIRE(child >= 0);
+  if(child == 0)
+  {
+    // Avoid Catch in the child, report through the exit status instead.
+    ::close(sockets[0]);
+    auto status = 0;
+    try
+    {
+      auto view = vm::shared_page_view(vm::receive_fd(sockets[1]));
+      auto size = std::size_t(0);
+      while(size < count * sizeof(int))
+      {
+        size = view.update();
+        auto const* const p = static_cast<int const*>(view.base());
+        for(std::size_t i = 0; i < size / sizeof(int); ++i)
+        {
+          if(p[i] != static_cast<int>(i))
+          {
+            status = 1;
+          }
+        }
+      }
+    }
+    catch(...)
+    {
+      status = 2;
+    }
+    ::_exit(status);
+  }
+  ::close(sockets[1]);
+
+  auto storage = vm::shared_page_stack(num_bytes(count * sizeof(int)));
+  vm::send_fd(sockets[0], storage.fd());
+  auto v = pinned_vector<int, shared_traits>(std::move(storage), 0);
+  ::close(sockets[0]);
+  for(auto i = 0; i < count; ++i)
+  {
+    v.push_back(i);
+    if(i % 1000 == 0)
+    {
+      v.flush();
+    }
+  }
+  v.flush();
+
+  auto status = 0;
+  REQUIRE(::waitpid(child, &status, 0) == child);
+  REQUIRE(WIFEXITED(status));
+  CHECK(WEXITSTATUS(status) == 0);
+}
+
+TEST_CASE("vm::receive_fd() fails when the peer closes the socket", "[shared_page_stack]")
+{
+  int sockets[2];
+  REQUIRE(::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) == 0);
+  ::close(sockets[0]);
+  CHECK_THROWS_AS(vm::receive_fd(sockets[1]), std::system_error);
+  ::close(sockets[1]);
+}
+
+#endif
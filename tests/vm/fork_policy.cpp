@@ -0,0 +1,131 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "vmcontainer/fork_policy.hpp"
+#include "vmcontainer/pinned_vector.hpp"
+
+#include "catch.hpp"
+
+#include <numeric>
+#include <system_error>
+
+#ifdef __linux__
+#  include <sys/wait.h>
+#  include <unistd.h>
+#endif
+
+using namespace mknejp::vmcontainer;
+
+#ifdef __linux__
+
+namespace
+{
+  template<vm::fork_behavior DefaultBehavior>
+  struct fork_traits
+  {
+    using storage_type = vm::page_stack_base<vm::fork_policy_system<vm::system_default, DefaultBehavior>>;
+    using growth_factor = pinned_vector_traits::growth_factor;
+  };
+
+  enum class child_view
+  {
+    copied,
+    wiped,
+    unmapped,
+    unexpected,
+  };
+
+  // Fork and report what the child sees of [v.begin(), v.end()), which must hold 0, 1, 2...
+  template<typename Vector>
+  auto view_from_child(Vector const& v) -> child_view
+  {
+    auto const child = ::fork();
+    REQUIRE(child >= 0);
+    if(child == 0)
+    {
+      // Avoid Catch in the child, report through the exit status instead.
+      auto result = child_view::unexpected;
+      try
+      {
+        // mincore() fails with ENOMEM for addresses that are not mapped.
+        vm::system_default::residency(v.data(), v.size() * sizeof(int));
+        if(std::equal(v.begin(), v.end(), Vector(max_elements(v.size()), v.size()).begin()))
+        {
+          result = child_view::wiped;
+        }
+        else
+        {
+          auto expected = static_cast<int>(0);
+          result = std::all_of(v.begin(), v.end(), [&](int x) { return x == expected++; }) ? child_view::copied
+                                                                                           : child_view::unexpected;
+        }
+      }
+      catch(std::system_error const&)
+      {
+        result = child_view::unmapped;
+      }
+      catch(...)
+      {
+      }
+      ::_exit(static_cast<int>(result));
+    }
+
+    auto status = 0;
+    REQUIRE(::waitpid(child, &status, 0) == child);
+    REQUIRE(WIFEXITED(status));
+    return static_cast<child_view>(WEXITSTATUS(status));
+  }
+}
+
+TEST_CASE("vm::fork_policy_system selected through traits", "[fork_policy_system]")
+{
+  SECTION("copy")
+  {
+    auto v = pinned_vector<int, fork_traits<vm::fork_behavior::copy>>(max_elements(100000), 50000);
+    std::iota(v.begin(), v.end(), 0);
+    CHECK(view_from_child(v) == child_view::copied);
+  }
+  SECTION("dont_fork")
+  {
+    auto v = pinned_vector<int, fork_traits<vm::fork_behavior::dont_fork>>(max_elements(100000), 50000);
+    std::iota(v.begin(), v.end(), 0);
+    CHECK(view_from_child(v) == child_view::unmapped);
+    CHECK(v[49999] == 49999);
+  }
+  SECTION("wipe")
+  {
+    auto v = pinned_vector<int, fork_traits<vm::fork_behavior::wipe>>(max_elements(100000), 50000);
+    std::iota(v.begin(), v.end(), 0);
+    CHECK(view_from_child(v) == child_view::wiped);
+    CHECK(v[49999] == 49999);
+  }
+}
+
+TEST_CASE("vm::fork_policy_system selected through the constructor", "[fork_policy_system]")
+{
+  using vector = pinned_vector<int, fork_traits<vm::fork_behavior::copy>>;
+  auto v = vector(max_elements(100000), 50000, vm::fork_policy_system<>(vm::fork_behavior::dont_fork));
+  std::iota(v.begin(), v.end(), 0);
+  CHECK(v.vm_system().behavior() == vm::fork_behavior::dont_fork);
+  CHECK(view_from_child(v) == child_view::unmapped);
+
+  SECTION("copies keep the behavior")
+  {
+    auto const w = v;
+    CHECK(view_from_child(w) == child_view::unmapped);
+  }
+
+  SECTION("relocated pages take the behavior of their new reservation")
+  {
+    auto w = vector(max_elements(0), vm::fork_policy_system<>(vm::fork_behavior::wipe));
+    w.relocate_to_larger_reservation(max_elements(200000));
+    w.append_pages(std::move(v));
+    CHECK(view_from_child(w) == child_view::wiped);
+    CHECK(w[49999] == 49999);
+  }
+}
+
+#endif
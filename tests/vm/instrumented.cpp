@@ -0,0 +1,134 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "vmcontainer/instrumented.hpp"
+#include "vmcontainer/pinned_vector.hpp"
+
+#include "catch.hpp"
+
+#include <numeric>
+#include <type_traits>
+
+using namespace mknejp::vmcontainer;
+
+#if VMCONTAINER_INSTRUMENTATION
+static_assert(sizeof(vm::reservation_base<vm::instrumented_system<>>) == sizeof(vm::reservation) + sizeof(void*), "");
+#else
+static_assert(std::is_empty<vm::instrumented_system<>>::value, "");
+static_assert(sizeof(vm::reservation_base<vm::instrumented_system<>>) == sizeof(vm::reservation), "");
+#endif
+
+namespace
+{
+  struct instrumented_traits
+  {
+    using storage_type = vm::page_stack_base<vm::instrumented_system<>>;
+    using growth_factor = pinned_vector_traits::growth_factor;
+  };
+}
+
+#if VMCONTAINER_INSTRUMENTATION
+namespace
+{
+  auto hook_calls = 0;
+  auto hook_bytes = std::size_t(0);
+
+  auto hook(vm::operation op, void*, std::size_t num_bytes, std::chrono::nanoseconds) -> void
+  {
+    if(op == vm::operation::commit)
+    {
+      ++hook_calls;
+      hook_bytes += num_bytes;
+    }
+  }
+
+  auto histogram_total(vm::operation_stats const& stats) -> std::uint64_t
+  {
+    return std::accumulate(stats.latency_histogram.begin(), stats.latency_histogram.end(), std::uint64_t(0));
+  }
+}
+
+TEST_CASE("vm::instrumented_system records the calls made through it", "[instrumented_system]")
+{
+  vm::vm_stats stats;
+  auto const page_size = vm::system_default::page_size();
+  {
+    auto v = pinned_vector<int, instrumented_traits>(max_pages(16), vm::instrumented_system<>(stats));
+    CHECK(v.vm_system().stats().live_reservations() == 1);
+    v.resize(page_size / sizeof(int) * 3);
+    v.resize(1);
+    v.shrink_to_fit();
+  }
+  CHECK(stats.live_reservations() == 0);
+
+  auto const reserve = stats.get(vm::operation::reserve);
+  CHECK(reserve.calls == 1);
+  CHECK(reserve.bytes == 16 * page_size);
+  CHECK(histogram_total(reserve) == 1);
+
+  auto const commit = stats.get(vm::operation::commit);
+  CHECK(commit.calls >= 1);
+  CHECK(commit.bytes == 3 * page_size);
+  CHECK(commit.failures == 0);
+  CHECK(histogram_total(commit) == commit.calls);
+  CHECK(commit.total_time.count() > 0);
+
+  auto const decommit = stats.get(vm::operation::decommit);
+  CHECK(decommit.calls == 1);
+  CHECK(decommit.bytes == 2 * page_size);
+
+  CHECK(stats.get(vm::operation::free).calls == 1);
+  CHECK(stats.get(vm::operation::free).bytes == 16 * page_size);
+
+  SECTION("hooks see every successful call")
+  {
+    stats.reset();
+    hook_calls = 0;
+    hook_bytes = 0;
+    stats.set_hook(&hook);
+    auto vmps = vm::page_stack_base<vm::instrumented_system<>>(num_pages(4), vm::instrumented_system<>(stats));
+    vmps.resize(2 * page_size);
+    stats.set_hook(nullptr);
+    vmps.resize(4 * page_size);
+    CHECK(hook_calls == 1);
+    CHECK(hook_bytes == 2 * page_size);
+    CHECK(stats.get(vm::operation::commit).calls == 2);
+  }
+
+  SECTION("failures are counted separately")
+  {
+    stats.reset();
+    auto vmr = vm::reservation_base<vm::instrumented_system<>>(num_pages(1), vm::instrumented_system<>(stats));
+    auto* const next = static_cast<char*>(vmr.base()) + page_size;
+    auto blocker = vm::reservation();
+    try
+    {
+      blocker = vm::reservation(next, num_pages(1));
+    }
+    catch(std::system_error const&)
+    {
+      // already occupied by something else
+    }
+    CHECK(vmr.try_extend(num_pages(2)) == false);
+    using reservation = vm::reservation_base<vm::instrumented_system<>>;
+    CHECK_THROWS_AS(reservation(next, num_pages(1), vm::instrumented_system<>(stats)), std::system_error);
+    CHECK(stats.get(vm::operation::extend).calls == 0);
+    CHECK(stats.get(vm::operation::extend).failures == 1);
+    CHECK(stats.get(vm::operation::reserve).calls == 1);
+    CHECK(stats.get(vm::operation::reserve).failures == 1);
+  }
+}
+#else
+TEST_CASE("vm::instrumented_system only forwards if instrumentation is disabled", "[instrumented_system]")
+{
+  vm::vm_stats stats;
+  auto v = pinned_vector<int, instrumented_traits>(max_pages(16), vm::instrumented_system<>(stats));
+  v.resize(100);
+  CHECK(v.size() == 100);
+  CHECK(stats.get(vm::operation::reserve).calls == 0);
+  CHECK(stats.get(vm::operation::commit).calls == 0);
+}
+#endif
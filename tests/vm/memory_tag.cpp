@@ -0,0 +1,113 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "vmcontainer/memory_tag.hpp"
+#include "vmcontainer/pinned_vector.hpp"
+
+#include "catch.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+
+using namespace mknejp::vmcontainer;
+
+namespace
+{
+  struct tagged_traits
+  {
+    using storage_type = vm::page_stack_base<vm::tagged_system<>>;
+    using growth_factor = pinned_vector_traits::growth_factor;
+  };
+
+  using vector = pinned_vector<char, tagged_traits>;
+
+  // The name of the mapping containing p in /proc/self/maps, or an empty string.
+  auto mapping_name(void const* p) -> std::string
+  {
+    auto* const file = std::fopen("/proc/self/maps", "re");
+    if(file == nullptr)
+    {
+      return {};
+    }
+    auto const address = reinterpret_cast<std::uintptr_t>(p);
+    auto result = std::string();
+    char line[512];
+    while(std::fgets(line, sizeof(line), file))
+    {
+      unsigned long long start = 0;
+      unsigned long long end = 0;
+      auto name = 0;
+      if(std::sscanf(line, "%llx-%llx %*s %*s %*s %*s %n", &start, &end, &name) >= 2 && start <= address
+         && address < end)
+      {
+        result = line + name;
+        result.erase(result.find_last_not_of("\n ") + 1);
+        break;
+      }
+    }
+    std::fclose(file);
+    return result;
+  }
+}
+
+TEST_CASE("vm::memory_tag", "[memory_tag]")
+{
+  auto& a = vm::memory_tag::get("test.memory_tag.a");
+  auto& b = vm::memory_tag::get("test.memory_tag.b");
+  CHECK(&vm::memory_tag::get("test.memory_tag.a") == &a);
+  CHECK(a.name() == "test.memory_tag.a");
+  CHECK(vector().vm_system().tag().name() == "untagged");
+
+  auto const page_size = vm::system_default::page_size();
+  {
+    auto v = vector(max_pages(16), vm::tagged_system<>(a));
+    v.resize(3 * page_size);
+    CHECK(a.stats().reserved_bytes == 16 * page_size);
+    CHECK(a.stats().committed_bytes == 3 * page_size);
+    v.resize(page_size);
+    CHECK(a.stats().committed_bytes == page_size);
+    CHECK(a.stats().peak_committed_bytes >= 3 * page_size);
+
+    SECTION("moved pages change tags")
+    {
+      auto w = vector(max_pages(16), vm::tagged_system<>(b));
+      w.append_pages(std::move(v));
+      CHECK(a.stats().committed_bytes == 0);
+      CHECK(b.stats().committed_bytes == page_size);
+    }
+
+    SECTION("copies use the same tag")
+    {
+      auto const w = v;
+      CHECK(a.stats().reserved_bytes == 32 * page_size);
+      CHECK(a.stats().committed_bytes == 2 * page_size);
+    }
+
+    SECTION("reservations are named after the tag")
+    {
+      if(vm::system_default::set_name(v.data(), page_size, "test.memory_tag.a"))
+      {
+        CHECK(mapping_name(v.data()) == "[anon:test.memory_tag.a]");
+        CHECK(mapping_name(v.data() + 15 * page_size) == "[anon:test.memory_tag.a]");
+      }
+    }
+
+    SECTION("dump() lists every tag")
+    {
+      auto out = std::ostringstream();
+      vm::memory_tag::dump(out);
+      CHECK(out.str().find("test.memory_tag.a") != std::string::npos);
+      CHECK(out.str().find("peak committed") != std::string::npos);
+    }
+  }
+  CHECK(a.stats().reserved_bytes == 0);
+  CHECK(a.stats().committed_bytes == 0);
+  CHECK(b.stats().reserved_bytes == 0);
+  CHECK(b.stats().committed_bytes == 0);
+}
@@ -19,6 +19,7 @@ static_assert(std::is_base_of<vm::page_stack_base<vm::system_default>, vm::page_
 static_assert(std::is_nothrow_default_constructible<vm::page_stack>::value, "");
 static_assert(std::is_nothrow_move_constructible<vm::page_stack>::value, "");
 static_assert(std::is_nothrow_move_assignable<vm::page_stack>::value, "");
+static_assert(sizeof(vm::page_stack) == sizeof(void*) + 2 * sizeof(std::size_t), "");
 
 TEST_CASE("vm::page_stack", "[page_stack]")
 {
@@ -350,4 +351,90 @@ TEST_CASE("vm::page_stack", "[page_stack]")
     CHECK(alloc.commit_calls() == 2);
     CHECK(alloc.decommit_calls() == 0);
   }
+
+  SECTION("append_pages_from() moves committed pages between stacks")
+  {
+    {
+      char block1[1000];
+      char block2[2000];
+      alloc.expect_reserve(block1, 1000);
+      auto vmps1 = page_stack(num_bytes(1000));
+      alloc.expect_commit(block1, 400);
+      vmps1.resize(400);
+      {
+        alloc.expect_reserve(block2, 2000);
+        auto vmps2 = page_stack(num_bytes(2000));
+        alloc.expect_commit(block2, 100);
+        vmps2.resize(100);
+
+        alloc.expect_move_pages(block1 + 100, block2 + 100, 300);
+        vmps2.append_pages_from(vmps1, 100);
+        CHECK(alloc.move_pages_calls() == 1);
+        CHECK(alloc.commit_calls() == 2);
+        CHECK(alloc.decommit_calls() == 0);
+        CHECK(vmps1.base() == block1);
+        CHECK(vmps2.base() == block2);
+        CHECK(vmps1.committed_bytes() == 100);
+        CHECK(vmps2.committed_bytes() == 400);
+
+        // nothing left to move
+        vmps2.append_pages_from(vmps1, 100);
+        CHECK(alloc.move_pages_calls() == 1);
+        alloc.expect_free(block2);
+      }
+      alloc.expect_free(block1);
+    }
+    CHECK(alloc.reservations() == 0);
+    CHECK(alloc.free_calls() == 2);
+  }
+
+  SECTION("adopting a partially committed reservation")
+  {
+    {
+      char block[1000];
+      alloc.expect_reserve(block, 1000);
+      auto vmps = page_stack(vm::reservation_base<virtual_memory_system_stub>(num_bytes(1000)), 300);
+      CHECK(vmps.base() == block);
+      CHECK(vmps.reserved_bytes() == 1000);
+      CHECK(vmps.committed_bytes() == 300);
+      CHECK(alloc.commit_calls() == 0);
+
+      alloc.expect_commit(block + 300, 100);
+      vmps.resize(400);
+      CHECK(alloc.commit_calls() == 1);
+      alloc.expect_free(block);
+    }
+    CHECK(alloc.reservations() == 0);
+    CHECK(alloc.free_calls() == 1);
+  }
+}
+
+TEST_CASE("vm::page_stack::residency() counts the pages that have been touched", "[page_stack]")
+{
+  auto const page_size = vm::system_default::page_size();
+  auto vmps = vm::page_stack(num_pages(16));
+  vmps.resize(8 * page_size);
+
+  auto const untouched = vmps.residency();
+  CHECK(untouched.resident_pages == 0);
+  CHECK(untouched.touched_pages == 0);
+  CHECK(untouched.huge_pages == 0);
+
+  auto* const p = static_cast<char*>(vmps.base());
+  p[0] = 1;
+  p[3 * page_size] = 1;
+  p[7 * page_size + 10] = 1;
+
+  auto const all = vmps.residency();
+  CHECK(all.resident_pages == 3);
+  CHECK(all.touched_pages == 3);
+  CHECK(all.huge_pages <= all.resident_pages);
+
+  auto const range = vmps.residency(page_size, 4 * page_size);
+  CHECK(range.resident_pages == 1);
+  CHECK(range.touched_pages == 1);
+
+  vmps.resize(4 * page_size);
+  vmps.resize(8 * page_size);
+  CHECK(vmps.residency().resident_pages == 2);
 }
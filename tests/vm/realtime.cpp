@@ -0,0 +1,94 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "vmcontainer/realtime.hpp"
+#include "vmcontainer/pinned_vector.hpp"
+
+#include "catch.hpp"
+
+#include <new>
+
+using namespace mknejp::vmcontainer;
+
+namespace
+{
+  struct realtime_traits
+  {
+    using storage_type = vm::realtime_page_stack;
+    using growth_factor = pinned_vector_traits::growth_factor;
+  };
+}
+
+TEST_CASE("vm::realtime_thread_scope", "[realtime]")
+{
+  CHECK(!vm::is_realtime_thread());
+  {
+    vm::realtime_thread_scope const outer;
+    CHECK(vm::is_realtime_thread());
+    {
+      vm::realtime_thread_scope const inner;
+      CHECK(vm::is_realtime_thread());
+    }
+    CHECK(vm::is_realtime_thread());
+  }
+  CHECK(!vm::is_realtime_thread());
+}
+
+TEST_CASE("vm::realtime_page_stack", "[realtime]")
+{
+  auto const page_size = vm::system_default::page_size();
+  auto stack = vm::realtime_page_stack(num_pages(4));
+  REQUIRE(stack.locked_bytes() == 4 * page_size);
+  CHECK(stack.committed_bytes() == 0);
+  CHECK(vm::system_default::residency(stack.base(), stack.locked_bytes()).resident_pages == 4);
+
+  {
+    vm::realtime_thread_scope const scope;
+    CHECK(stack.resize(page_size + 1) == 2 * page_size);
+    CHECK(stack.resize(0) == 0);
+    CHECK(stack.resize(4 * page_size) == 4 * page_size);
+    CHECK_THROWS_AS(stack.resize(5 * page_size), std::bad_alloc);
+    CHECK(stack.committed_bytes() == 4 * page_size);
+  }
+
+  SECTION("try_extend() locks the new pages")
+  {
+    if(stack.try_extend(num_pages(8)))
+    {
+      CHECK(stack.locked_bytes() == 8 * page_size);
+      CHECK(stack.resize(8 * page_size) == 8 * page_size);
+    }
+  }
+}
+
+TEST_CASE("pinned_vector with realtime_page_stack makes no system calls after construction", "[realtime]")
+{
+  auto v = pinned_vector<int, realtime_traits>(max_elements(10000));
+  auto w = pinned_vector<int, realtime_traits>(max_elements(10000));
+  {
+    vm::realtime_thread_scope const scope;
+    for(auto i = 0; i < 10000; ++i)
+    {
+      v.push_back(i);
+    }
+    v.resize(10);
+    v.shrink_to_fit();
+    v.resize(4096, 42);
+    w.append_pages(std::move(v));
+    CHECK(w.size() == 4096);
+    CHECK(w[9] == 9);
+    CHECK(w[4095] == 42);
+    CHECK(v.empty());
+  }
+
+  SECTION("split_off() copies the elements into a new locked reservation")
+  {
+    auto const tail = w.split_off(1024);
+    CHECK(w.size() == 1024);
+    CHECK(tail.size() == 3072);
+    CHECK(tail.capacity() == 3072);
+  }
+}
@@ -0,0 +1,114 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "vmcontainer/registry.hpp"
+#include "vmcontainer/pinned_vector.hpp"
+
+#include "catch.hpp"
+
+using namespace mknejp::vmcontainer;
+
+namespace
+{
+  struct registered_traits
+  {
+    using storage_type = vm::registered_page_stack<>;
+    using growth_factor = pinned_vector_traits::growth_factor;
+  };
+
+  using registered_vector = pinned_vector<char, registered_traits>;
+
+  struct throws_on_construction
+  {
+    explicit throws_on_construction(bool fail)
+    {
+      if(fail)
+      {
+        throw 42;
+      }
+    }
+  };
+}
+
+TEST_CASE("vm::page_stack_registry tracks live registered_page_stacks", "[registry]")
+{
+  auto& registry = vm::page_stack_registry::instance();
+  auto const page_size = vm::system_default::page_size();
+  auto const before = registry.stats();
+  {
+    auto v = registered_vector(max_pages(16));
+    auto w = registered_vector();
+    CHECK(registry.stats().num_stacks == before.num_stacks + 1);
+
+    v.reserve(4 * page_size);
+    v.resize(page_size + 1);
+    auto const stats = registry.stats();
+    CHECK(stats.committed_bytes == before.committed_bytes + 4 * page_size);
+    CHECK(stats.used_bytes == before.used_bytes + page_size + 1);
+
+    w = std::move(v);
+    CHECK(registry.stats().num_stacks == before.num_stacks + 1);
+    CHECK(registry.stats().committed_bytes == before.committed_bytes + 4 * page_size);
+  }
+  CHECK(registry.stats().num_stacks == before.num_stacks);
+  CHECK(registry.stats().committed_bytes == before.committed_bytes);
+}
+
+TEST_CASE("vm::page_stack_registry reports the used bytes after constructing the elements", "[registry]")
+{
+  auto& registry = vm::page_stack_registry::instance();
+  auto const before = registry.stats();
+  auto v = pinned_vector<throws_on_construction, registered_traits>(max_pages(16));
+  v.emplace_back(false);
+  CHECK(registry.stats().used_bytes == before.used_bytes + sizeof(throws_on_construction));
+  CHECK_THROWS_AS(v.emplace_back(true), int);
+  CHECK(v.size() == 1);
+  CHECK(registry.stats().used_bytes == before.used_bytes + sizeof(throws_on_construction));
+}
+
+TEST_CASE("vm::page_stack_registry::trim_all()", "[registry]")
+{
+  auto& registry = vm::page_stack_registry::instance();
+  auto const page_size = vm::system_default::page_size();
+  auto v = registered_vector(max_pages(16));
+  v.reserve(8 * page_size);
+  v.resize(page_size);
+
+  SECTION("slack is decommitted at the next mutation")
+  {
+    CHECK(registry.trim_all() == 7 * page_size);
+    CHECK(v.capacity() == 8 * page_size);
+    v.push_back('x');
+    CHECK(v.capacity() == 2 * page_size);
+    CHECK(v.size() == page_size + 1);
+    CHECK(registry.stats().committed_bytes >= 2 * page_size);
+  }
+
+  SECTION("pop_back() honours trim requests")
+  {
+    registry.trim_all();
+    v.pop_back();
+    CHECK(v.capacity() == page_size);
+  }
+
+  SECTION("retained slack is kept")
+  {
+    auto policy = vm::trim_policy();
+    policy.retained_slack_bytes = 2 * page_size;
+    CHECK(registry.trim_all(policy) == 5 * page_size);
+    v.pop_back();
+    CHECK(v.capacity() == 3 * page_size);
+  }
+
+  SECTION("stacks with less slack than min_trimmed_bytes are left alone")
+  {
+    auto policy = vm::trim_policy();
+    policy.min_trimmed_bytes = 8 * page_size;
+    CHECK(registry.trim_all(policy) == 0);
+    v.pop_back();
+    CHECK(v.capacity() == 8 * page_size);
+  }
+}
@@ -10,6 +10,9 @@
 
 #include "catch.hpp"
 
+#include <algorithm>
+#include <cstdint>
+#include <system_error>
 #include <type_traits>
 
 using namespace mknejp::vmcontainer;
@@ -19,6 +22,8 @@ static_assert(std::is_base_of<vm::reservation_base<vm::system_default>, vm::rese
 static_assert(std::is_nothrow_default_constructible<vm::reservation>::value, "");
 static_assert(std::is_nothrow_move_constructible<vm::reservation>::value, "");
 static_assert(std::is_nothrow_move_assignable<vm::reservation>::value, "");
+// A stateless virtual memory system takes no space.
+static_assert(sizeof(vm::reservation) == sizeof(void*) + sizeof(std::size_t), "");
 
 TEST_CASE("vm::reservation", "[reservation]")
 {
@@ -177,4 +182,153 @@ TEST_CASE("vm::reservation", "[reservation]")
     CHECK(alloc.reserve_calls() == 2);
     CHECK(alloc.free_calls() == 2);
   }
+
+  SECTION("try_extend() grows the reservation in place")
+  {
+    {
+      char block[300];
+      alloc.expect_reserve(block, 100);
+      auto vmr = reservation(num_bytes(100));
+      alloc.expect_extend(block, block + 100, 200);
+      CHECK(vmr.try_extend(num_bytes(250)) == true);
+      CHECK(alloc.extend_calls() == 1);
+      CHECK(vmr.base() == block);
+      CHECK(vmr.reserved_bytes() == 300);
+      alloc.expect_free(block);
+    }
+    CHECK(alloc.reservations() == 0);
+    CHECK(alloc.reserve_calls() == 1);
+    CHECK(alloc.free_calls() == 1);
+  }
+
+  SECTION("try_extend() to a smaller or equal size is a no-op")
+  {
+    char block[200];
+    alloc.expect_reserve(block, 200);
+    auto vmr = reservation(num_bytes(200));
+    CHECK(vmr.try_extend(num_bytes(200)) == true);
+    CHECK(vmr.try_extend(num_pages(1)) == true);
+    CHECK(alloc.extend_calls() == 0);
+    CHECK(vmr.base() == block);
+    CHECK(vmr.reserved_bytes() == 200);
+    alloc.expect_free(block);
+  }
+
+  SECTION("try_extend() leaves the reservation untouched if the adjacent address range is taken")
+  {
+    {
+      char block[100];
+      alloc.expect_reserve(block, 100);
+      auto vmr = reservation(num_bytes(100));
+      alloc.expect_extend_and_fail(block + 100, 100);
+      CHECK(vmr.try_extend(num_pages(2)) == false);
+      CHECK(alloc.extend_calls() == 1);
+      CHECK(vmr.base() == block);
+      CHECK(vmr.reserved_bytes() == 100);
+      alloc.expect_free(block);
+    }
+    CHECK(alloc.reservations() == 0);
+    CHECK(alloc.free_calls() == 1);
+  }
+
+  SECTION("try_extend() on an empty reservation creates a new one")
+  {
+    {
+      char block[200];
+      auto vmr = reservation();
+      alloc.expect_reserve(block, 200);
+      CHECK(vmr.try_extend(num_bytes(150)) == true);
+      CHECK(alloc.extend_calls() == 0);
+      CHECK(vmr.base() == block);
+      CHECK(vmr.reserved_bytes() == 200);
+      alloc.expect_free(block);
+    }
+    CHECK(alloc.reservations() == 0);
+    CHECK(alloc.reserve_calls() == 1);
+    CHECK(alloc.free_calls() == 1);
+  }
+
+  SECTION("ctor reserves with an alignment larger than the page size")
+  {
+    {
+      char block[200];
+      alloc.expect_reserve_aligned(block, 200, 256);
+      auto vmr = reservation(num_bytes(150).aligned_to(256));
+      CHECK(alloc.reserve_calls() == 1);
+      CHECK(vmr.base() == block);
+      CHECK(vmr.reserved_bytes() == 200);
+      alloc.expect_free(block);
+    }
+    CHECK(alloc.reservations() == 0);
+    CHECK(alloc.free_calls() == 1);
+  }
+
+  SECTION("ctor ignores alignments up to the page size")
+  {
+    {
+      char block[200];
+      alloc.expect_reserve(block, 200);
+      auto vmr = reservation(num_bytes(150).aligned_to(64));
+      CHECK(vmr.base() == block);
+      alloc.expect_free(block);
+    }
+    CHECK(alloc.reserve_calls() == 1);
+  }
+
+  SECTION("ctor with an address reserves at that address")
+  {
+    // The address must be page aligned.
+    virtual_memory_system_stub::page_size = [] { return 64; };
+    {
+      alignas(64) char block[128];
+      alloc.expect_reserve_at(block, 128);
+      auto vmr = reservation(block, num_bytes(100));
+      CHECK(alloc.reserve_calls() == 1);
+      CHECK(vmr.base() == block);
+      CHECK(vmr.reserved_bytes() == 128);
+      alloc.expect_free(block);
+    }
+    CHECK(alloc.reservations() == 0);
+    CHECK(alloc.free_calls() == 1);
+  }
+}
+
+TEST_CASE("vm::reservation with alignment", "[reservation]")
+{
+  auto const page_size = vm::system_default::page_size();
+  for(auto const alignment : {page_size / 2, page_size, std::size_t(1) << 21, std::size_t(1) << 30})
+  {
+    CAPTURE(alignment);
+    auto vmr = vm::reservation(num_pages(3).aligned_to(alignment));
+    CHECK(reinterpret_cast<std::uintptr_t>(vmr.base()) % alignment == 0);
+    CHECK(vmr.reserved_bytes() == 3 * page_size);
+    CHECK(vmr.alignment() == std::max(alignment, page_size));
+    auto const moved = std::move(vmr);
+    CHECK(moved.alignment() == std::max(alignment, page_size));
+  }
+}
+
+TEST_CASE("vm::reservation at a fixed address", "[reservation]")
+{
+  auto const page_size = vm::system_default::page_size();
+  auto address = vm::reservation(num_pages(4)).base();
+  // The range is free again once the temporary reservation is gone.
+  auto vmr = vm::reservation(address, num_pages(4));
+  CHECK(vmr.base() == address);
+  CHECK(vmr.reserved_bytes() == 4 * page_size);
+
+  SECTION("fails without replacing an existing reservation")
+  {
+    auto* const overlapping = static_cast<char*>(address) + 2 * page_size;
+    try
+    {
+      vm::reservation(overlapping, num_pages(4));
+      FAIL("reservation over an occupied range succeeded");
+    }
+    catch(std::system_error const& e)
+    {
+      CHECK(e.code() == std::errc::file_exists);
+    }
+    CHECK(vmr.base() == address);
+  }
 }
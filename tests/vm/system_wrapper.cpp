@@ -0,0 +1,116 @@
+//
+// Copyright Miro Knejp 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "vmcontainer/budget.hpp"
+#include "vmcontainer/dump_policy.hpp"
+#include "vmcontainer/fork_policy.hpp"
+#include "vmcontainer/instrumented.hpp"
+#include "vmcontainer/memory_tag.hpp"
+#include "vmcontainer/pinned_vector.hpp"
+
+#include "catch.hpp"
+
+#include <numeric>
+
+using namespace mknejp::vmcontainer;
+
+namespace
+{
+  template<typename VirtualMemorySystem>
+  struct wrapped_traits
+  {
+    using storage_type = vm::page_stack_base<VirtualMemorySystem>;
+    using growth_factor = pinned_vector_traits::growth_factor;
+  };
+
+  template<typename VirtualMemorySystem>
+  using vector = pinned_vector<int, wrapped_traits<VirtualMemorySystem>>;
+
+  // Detects whether a system accounts for committed pages.
+  template<typename VMS>
+  auto has_discard(VMS& vms, int) -> decltype(vms.discard(nullptr, 0), true)
+  {
+    return true;
+  }
+  template<typename VMS>
+  auto has_discard(VMS&, long) -> bool
+  {
+    return false;
+  }
+}
+
+TEST_CASE("vm::system_wrapper only provides the optional operations of the wrapped system", "[system_wrapper]")
+{
+  auto plain = vm::fork_policy_system<>();
+  auto budgeted = vm::fork_policy_system<vm::budgeted_system<>>();
+  CHECK(!has_discard(plain, 0));
+  CHECK(has_discard(budgeted, 0));
+  CHECK(has_discard(budgeted.inner(), 0));
+}
+
+#ifdef __linux__
+
+TEST_CASE("vm::system_wrapper lets wrappers be stacked in any order", "[system_wrapper]")
+{
+  auto const page_size = vm::system_default::page_size();
+  auto& tag = vm::memory_tag::get("test.system_wrapper");
+
+  SECTION("tagged_system<fork_policy_system<>>")
+  {
+    using system = vm::tagged_system<vm::fork_policy_system<>>;
+    {
+      auto v = vector<system>(max_pages(16), system(tag, vm::fork_policy_system<>(vm::fork_behavior::dont_fork)));
+      v.resize(page_size / sizeof(int) * 2);
+      std::iota(v.begin(), v.end(), 0);
+      CHECK(v.vm_system().inner().behavior() == vm::fork_behavior::dont_fork);
+      CHECK(v.advise(v.begin(), v.end(), vm::access_hint::normal));
+      CHECK(tag.stats().reserved_bytes == 16 * page_size);
+      CHECK(tag.stats().committed_bytes == 2 * page_size);
+    }
+    CHECK(tag.stats().reserved_bytes == 0);
+    CHECK(tag.stats().committed_bytes == 0);
+  }
+  SECTION("dump_policy_system<tagged_system<>>")
+  {
+    using system = vm::dump_policy_system<vm::tagged_system<>>;
+    {
+      auto v = vector<system>(max_pages(16), system(vm::dump_policy::first(page_size), vm::tagged_system<>(tag)));
+      v.resize(page_size / sizeof(int) * 3);
+      CHECK(tag.stats().committed_bytes == 3 * page_size);
+    }
+    CHECK(tag.stats().committed_bytes == 0);
+  }
+  SECTION("fork_policy_system<budgeted_system<>> passes discard() on")
+  {
+    using system = vm::fork_policy_system<vm::budgeted_system<>>;
+    vm::memory_budget budget(vm::memory_budget::unlimited, nullptr);
+    {
+      auto v = vector<system>(max_pages(16), system(vm::fork_behavior::wipe, vm::budgeted_system<>(budget)));
+      v.resize(page_size / sizeof(int) * 4);
+      CHECK(budget.committed_bytes() == 4 * page_size);
+      auto tail = v.split_off(page_size / sizeof(int) * 2);
+      CHECK(budget.committed_bytes() == 4 * page_size);
+    }
+    CHECK(budget.committed_bytes() == 0);
+  }
+  SECTION("instrumented_system<tagged_system<budgeted_system<>>>")
+  {
+    using tagged = vm::tagged_system<vm::budgeted_system<>>;
+    using system = vm::instrumented_system<tagged>;
+    vm::vm_stats stats;
+    vm::memory_budget budget(vm::memory_budget::unlimited, nullptr);
+    {
+      auto v = vector<system>(max_pages(16), system(stats, tagged(tag, vm::budgeted_system<>(budget))));
+      v.resize(page_size / sizeof(int));
+      CHECK(budget.committed_bytes() == page_size);
+      CHECK(tag.stats().committed_bytes == page_size);
+    }
+    CHECK(budget.committed_bytes() == 0);
+    CHECK(tag.stats().committed_bytes == 0);
+  }
+}
+
+#endif